@@ -3,19 +3,104 @@
 #include "semaphore.h"
 #include "worldlocation.h"
 #include "library/zonedetect.h"
+#include "TzSnapshot.h"
 #include <string>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
 
-class TimezoneMapper {
+class TIMES_API TimezoneMapper {
 public:
 	static const HSS_Time::TimeZoneInfo* getTz(const double lat, const double lng, INTNM::int16_t set, bool* valid);
+	static void getTzBatch(const double* lat, const double* lng, std::size_t count, INTNM::int16_t set, const HSS_Time::TimeZoneInfo** tzi, bool* valid);
 	static const HSS_Time::TimeZoneInfo* fromName(const char *name, INTNM::int16_t set);
 	static const HSS_Time::TimeZoneInfo* fromId(std::uint32_t id, INTNM::int16_t set);
-	static std::vector<HSS_Time::TimeZoneInfo*> timezones;
+	static std::vector<HSS_Time::TimeZoneInfo*> timezones;			// only modified while lock is held, readers should use fromName/fromId
+
+	// getTz remembers its answer per lat/lon tile when ZoneDetect reports the whole tile is inside the zone
+	static void setTileResolution(double degrees);					// 0 disables the cache, otherwise clamped to [0.001, 10] degrees
+	static double tileResolution();
+	static void tileStatistics(std::uint64_t* hits, std::uint64_t* misses);
+	static void clearTileCache();
+
+	// open the ZoneDetect database from a file instead of the embedded copy, which is also what WTIME_ZONEDETECT_DB does,
+	// returns false if the database is already open
+	static bool setDatabasePath(const std::string& path);
+
+	// run initTz on a background thread so the first lookup doesn't pay for it, lookups that arrive before it's
+	// done wait for it on lock. Only the first call does anything.
+	static void prewarm();
+	// wait for the thread prewarm started, for shutting down before the library is unloaded. Nothing happens if there isn't one.
+	static void finishPrewarm();
+
+	// the tzdb snapshot image compiled into the library, which TzSnapshot::open accepts
+	static const void* snapshotImage(std::size_t* size);
+
+	// parse the tzdb text, this only happens on its own when there's no snapshot or the snapshot is missing a zone
+	static void loadTzdb();
+	// make sure the tzdb can locate one zone, when lazy only the files it needs are parsed (if date has reload_tzdb)
+	static void loadTzdb(std::string_view zone);
+	// parse the tzdb a region file at a time as zones are needed instead of all at once, set before the first lookup
+	static void setLazyTzdb(bool lazy);
+	static bool lazyTzdb();
+
+	// the tzdb source files, a bit each in tzdbFilesLoaded
+	enum : std::uint32_t {
+		TZDB_AFRICA = 1 << 0, TZDB_ANTARCTICA = 1 << 1, TZDB_ASIA = 1 << 2, TZDB_AUSTRALASIA = 1 << 3, TZDB_ETCETERA = 1 << 4,
+		TZDB_EUROPE = 1 << 5, TZDB_NORTHAMERICA = 1 << 6, TZDB_SOUTHAMERICA = 1 << 7, TZDB_BACKWARD = 1 << 8, TZDB_LEAPSECONDS = 1 << 9
+	};
+	// the files that have been parsed so far, and whether that was every one of them (loadTzdb() rather than a lazy load)
+	static std::uint32_t tzdbFilesLoaded();
+	static bool tzdbFullyLoaded();
 
 private:
+	// Read-mostly index over timezones. Readers never lock, they load the current registry and
+	// probe it. Writers (addTz) hold lock, publish new entries with release stores, and grow by
+	// publishing a larger copy. A replaced registry is chained to its successor and never freed so
+	// that a reader still holding it stays valid, the chain is geometric so it costs O(n) overall.
+	struct Registry {
+		explicit Registry(std::uint32_t capacity);
+
+		std::uint32_t m_capacity;										// size of m_byName, a power of 2, m_byId holds half as many
+		std::atomic<std::uint32_t> m_count;								// number of entries published in m_byId
+		std::unique_ptr<std::atomic<const HSS_Time::TimeZoneInfo*>[]> m_byId;		// indexed by m_id - OPEN_TIMEZONE_ID
+		std::unique_ptr<std::atomic<const HSS_Time::TimeZoneInfo*>[]> m_byName;	// open addressed on a case insensitive hash of m_name
+		std::unique_ptr<Registry> m_retired;
+	};
+
+	// Direct mapped tile cache, each slot packs the tile key and the registry index of its zone so a
+	// single atomic load is a complete, consistent entry. See the TILE_ constants in the .cpp.
+	static constexpr std::uint32_t TILE_CACHE_SIZE = 65536;
+	static std::atomic<std::uint64_t> tileCache[TILE_CACHE_SIZE];
+	static std::atomic<std::uint64_t> tileConfig;					// epoch << 32 | resolution in micro-degrees
+	static std::atomic<std::uint64_t> tileHits, tileMisses;
+
+	// The zone each ZoneDetect meta entry resolved to, indexed by metaId * 2 + (set != 0), so repeat lookups skip
+	// building the zone name and querying the tzdb.
+	static constexpr std::uint32_t ZONE_MEMO_SIZE = 4096;
+	static std::atomic<const HSS_Time::TimeZoneInfo*> zoneMemo[ZONE_MEMO_SIZE * 2];
+
+	static std::unordered_map<std::string, const HSS_Time::TimeZoneTransitions*> transitionTables;	// by zone name, shared by its std and dst entries, only used while lock is held
+
 	static CThreadSemaphore lock;
+	static CThreadSemaphore tzdbLock;									// only held while the tzdb text is parsed, never held while taking lock
 	static ZoneDetect* cd;
+	static std::string databasePath;								// only used while lock is held
+	static HSS_Time_Private::TzSnapshot snapshot;
+	static std::atomic<bool> tzdbLoaded;								// every file has been parsed
+	static std::atomic<bool> tzdbLazy;
+	static std::atomic<std::uint32_t> tzdbFiles;						// the tzdb files that have been parsed, one bit each
+	static std::atomic<bool> initialized;
+	static std::atomic<bool> prewarmStarted;
+	static std::atomic<Registry*> registry;
 
 	static bool initTz();
+	static void registerTzdb(std::uint32_t files, bool windows);
+	static void sampleZone(std::string_view name, const char** canonical, date::sys_info* infos, date::sys_info* infod);
 	static const HSS_Time::TimeZoneInfo* addTz(const date::sys_info& si, const std::string& name);
+	static const HSS_Time::TimeZoneInfo* findTz(const date::sys_info& si, const char* name);
+	static const HSS_Time::TimeZoneInfo* findName(const char* name, INTNM::int16_t set);
+	static void publishTz(const HSS_Time::TimeZoneInfo* tzi);
+	static const HSS_Time::TimeZoneTransitions* transitionsFor(const std::string& name);
+	static const HSS_Time::TimeZoneInfo* zoneFromResult(const ZoneDetectResult& result, INTNM::int16_t set);
 };
@@ -20,7 +20,13 @@
 
 #include "internal/worldlocation.h"
 #include "internal/Times.h"
+#include "internal/WTimePoint.h"
+#include "internal/WTimeFormatter.h"
+#include "internal/WTimeRange.h"
+#include "internal/WTimeSeries.h"
 #include "internal/SunriseSunsetCalc.h"
+#include "internal/SolarPosition.h"
+#include "internal/TimezoneGrid.h"
 
 #if !defined(_MANAGED) && defined(GOOGLE_PROTOBUF_VERSION)
 #include "internal/WTimeProto.h"
@@ -0,0 +1,113 @@
+/**
+ * CivilCalendar.h
+ *
+ * Copyright 2016-2023 Heartland Software Solutions Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the license at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the LIcense is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "times_internal.h"
+
+#include <cstdint>
+
+
+namespace HSS_Time {
+namespace CivilCalendar {
+
+// Conversions between the proleptic Gregorian calendar and a count of days since January 1, 1600, the day WTime counts
+// from. Years are counted from March so that the leap day is the last day of the year, which leaves only divisions by
+// constants (the compiler turns them into multiplies) and no table lookups. They're constexpr so they can be used to build
+// constants, and they agree with WTime's original Julian day arithmetic for every day from 1600 to 2400.
+
+constexpr std::int64_t DAYS_PER_ERA = 146097;			// days in 400 years, the calendar repeats after this
+constexpr std::int64_t MARCH_1_1600 = 60;				// 1600 is a leap year
+
+struct CivilDate {
+	INTNM::int32_t	m_year;
+	INTNM::int32_t	m_month;			// month of year (1 = Jan)
+	INTNM::int32_t	m_day;				// day of month
+};
+
+
+constexpr bool IsLeapYear(INTNM::int32_t year) {
+	return ((year % 4) == 0) && (((year % 100) != 0) || ((year % 400) == 0));
+}
+
+
+/// <summary>
+/// Days since January 1, 1600 for a year, month [1..12] and day [1..31]. Days and months outside of those ranges roll
+/// over into the next (or previous) month and year.
+/// </summary>
+constexpr std::int64_t DaysFromCivil(INTNM::int32_t year, INTNM::int32_t month, INTNM::int32_t day) {
+	const std::int64_t y = (std::int64_t)year - 1600 - (month <= 2);
+	const std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+	const std::int64_t year_of_era = y - era * 400;
+	const std::int64_t day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;		// from March 1
+	const std::int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+	return era * DAYS_PER_ERA + day_of_era + MARCH_1_1600;
+}
+
+
+/// <summary>
+/// The year, month and day for a count of days since January 1, 1600.
+/// </summary>
+constexpr CivilDate CivilFromDays(std::int64_t days) {
+	const std::int64_t z = days - MARCH_1_1600;
+	const std::int64_t era = (z >= 0 ? z : z - (DAYS_PER_ERA - 1)) / DAYS_PER_ERA;
+	const std::int64_t day_of_era = z - era * DAYS_PER_ERA;
+	const std::int64_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / (DAYS_PER_ERA - 1)) / 365;
+	const std::int64_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);	// from March 1
+	const std::int64_t month_from_march = (5 * day_of_year + 2) / 153;
+	const INTNM::int32_t month = (INTNM::int32_t)(month_from_march < 10 ? month_from_march + 3 : month_from_march - 9);
+	return CivilDate{ (INTNM::int32_t)(year_of_era + era * 400 + 1600 + (month <= 2)), month,
+		(INTNM::int32_t)(day_of_year - (153 * month_from_march + 2) / 5 + 1) };
+}
+
+
+/// <summary>
+/// Days since January 1, 1600 for January 1 of a year.
+/// </summary>
+constexpr std::int64_t YearStart(INTNM::int32_t year) {
+	const std::int64_t y = (std::int64_t)year - 1601;		// the March based year that January 1 falls in
+	const std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+	const std::int64_t year_of_era = y - era * 400;
+	return era * DAYS_PER_ERA + year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + 306 + MARCH_1_1600;
+}
+
+
+/// <summary>
+/// Day of the year for a date, January 1 is 1.
+/// </summary>
+constexpr INTNM::int32_t DayOfYear(INTNM::int32_t year, INTNM::int32_t month, INTNM::int32_t day) {
+	return (INTNM::int32_t)(DaysFromCivil(year, month, day) - YearStart(year)) + 1;
+}
+
+
+/// <summary>
+/// Day of the week for a count of days since January 1, 1600, 1=Sun through 7=Sat as WTime::GetDayOfWeek returns.
+/// </summary>
+constexpr INTNM::int32_t DayOfWeek(std::int64_t days) {
+	const INTNM::int32_t day_of_week = (INTNM::int32_t)(((days % 7) + 7) % 7);
+	return day_of_week == 0 ? 7 : day_of_week;
+}
+
+
+static_assert(DaysFromCivil(1600, 1, 1) == 0, "WTime counts days from January 1, 1600");
+static_assert(YearStart(1601) == 366, "1600 is a leap year");
+static_assert(CivilFromDays(DaysFromCivil(2000, 2, 29)).m_day == 29, "2000 is a leap year");
+static_assert(DayOfYear(2100, 12, 31) == 365, "2100 isn't a leap year");
+
+};
+};
@@ -0,0 +1,76 @@
+/**
+ * SolarPosition.h
+ *
+ * Copyright 2016-2023 Heartland Software Solutions Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the license at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the LIcense is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "times_internal.h"
+#include "SunriseSunsetCalc.h"
+
+#include <cstddef>
+
+
+namespace HSS_Time_Private {
+
+/// <summary>
+/// The sun's elevation and azimuth at one position, for any number of times. It uses the same NOAA ephemeris as
+/// CSunriseSunsetCalc: the declination and equation of time are taken from the shared per-day table at the start of
+/// the day and of the next day, and interpolated between them, so stepping through a day only works out the hour
+/// angle and the angles that follow from it. The interpolation is within about a thousandth of a degree of evaluating
+/// the ephemeris at every time. Not thread safe, use one per thread.
+/// </summary>
+class TIMES_API SolarPosition {
+public:
+	/// <summary>
+	/// The position, in radians as WorldLocation keeps it (east and north positive).
+	/// </summary>
+	SolarPosition(double latitude, double longitude);
+
+	/// <summary>
+	/// The sun's position at a time.
+	/// </summary>
+	/// <param name="time">Microseconds since 1600 UTC, as WTime::GetTotalMicroSeconds.</param>
+	/// <param name="elevation">Receives the geometric elevation above the horizon in radians, without refraction.</param>
+	/// <param name="azimuth">Receives the azimuth in radians, clockwise from north, in [0, 2pi).</param>
+	void Position(INTNM::uint64_t time, double *elevation, double *azimuth);
+	/// <summary>
+	/// The sun's position at count times, as for Position. Times in the same day share the day's terms so a time
+	/// series should be passed in order.
+	/// </summary>
+	void Positions(const INTNM::uint64_t *times, std::size_t count, double *elevation, double *azimuth);
+	/// <summary>
+	/// The sun's position at count evenly spaced times, as for Position. Within a day each step only rotates the hour
+	/// angle and declination by a fixed angle, so no trigonometry is done past the first time of each day other than
+	/// for the elevation and azimuth themselves.
+	/// </summary>
+	/// <param name="start">The first time, microseconds since 1600 UTC.</param>
+	/// <param name="step">Microseconds between the times, may be negative.</param>
+	void Positions(INTNM::uint64_t start, INTNM::int64_t step, std::size_t count, double *elevation, double *azimuth);
+
+private:
+	void loadDay(INTNM::int64_t day);
+	void position(double sinDec, double cosDec, double sinHA, double cosHA, double *elevation, double *azimuth) const;
+
+	CSunriseSunsetCalc m_calc;
+	double m_sinLatitude, m_cosLatitude;
+	double m_longitude;							// radians, east positive
+	INTNM::int64_t m_day;						// days since 1600 that the terms below are for, -1 for none yet
+	double m_declination, m_declinationChange;	// radians at the start of the day, and over the day
+	double m_eqTime, m_eqTimeChange;			// equation of time as an hour angle, radians
+};
+
+};
@@ -0,0 +1,86 @@
+/**
+ * SunCache.h
+ *
+ * Copyright 2016-2023 Heartland Software Solutions Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the license at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the LIcense is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "times_internal.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+
+namespace HSS_Time_Private {
+
+/// <summary>
+/// Sunrise, sunset and solar noon results for a WorldLocation, keyed on what they depend on: the solar day and the
+/// position. Positions are rounded to a grid of 2^-32 radians (about 1.5mm) so the key compares as integers. Once full
+/// the least recently useful entry is replaced by the CLOCK policy: every hit marks its entry, and the replacement hand
+/// skips (and unmarks) marked entries. It's meant for a few dozen entries, lookups scan every one after trying the
+/// last hit. Thread safe.
+/// </summary>
+class SunCache {
+public:
+	static constexpr std::size_t DEFAULT_CAPACITY = 16;
+
+	struct Key {
+		INTNM::int64_t	m_day;						// days since 1600 in solar time
+		INTNM::int64_t	m_latitude;					// radians * 2^32
+		INTNM::int64_t	m_longitude;
+
+		Key() = default;
+		Key(INTNM::int64_t day, double latitude, double longitude);
+
+		bool operator==(const Key &k) const noexcept	{ return (m_day == k.m_day) && (m_latitude == k.m_latitude) && (m_longitude == k.m_longitude); }
+	};
+	struct Value {
+		INTNM::uint64_t	m_rise,						// seconds since 1600, UTC
+						m_set,
+						m_noon;
+		INTNM::int16_t	m_success;
+	};
+
+	explicit SunCache(std::size_t capacity = DEFAULT_CAPACITY);
+	SunCache(const SunCache &cache);				// same capacity, but starts empty
+	SunCache &operator=(const SunCache &cache) = delete;
+
+	bool Retrieve(const Key &key, Value *value);
+	void Store(const Key &key, const Value &value);
+
+	std::size_t Capacity() const;
+	void SetCapacity(std::size_t capacity);			// also empties the cache, 0 disables it
+	void Statistics(std::uint64_t *hits, std::uint64_t *misses) const;
+	void Clear();									// the entries and the statistics
+
+private:
+	struct Entry {
+		Key		m_key;
+		Value	m_value;
+		bool	m_referenced;
+	};
+
+	mutable std::mutex m_lock;
+	std::vector<Entry> m_entries;					// only allocated on the first store, grows up to m_capacity
+	std::size_t m_capacity;
+	std::size_t m_hand;								// next entry the CLOCK considers replacing
+	std::size_t m_last;								// most recent hit, hourly loops ask for the same day many times in a row
+	std::uint64_t m_hits, m_misses;
+};
+
+};
@@ -25,6 +25,7 @@
 
 #include "times_internal.h"
 
+#include <cstddef>
 #include <string>
 
 #ifdef HSS_SHOULD_PRAGMA_PACK
@@ -57,12 +58,18 @@ typedef struct TIMES_API _RiseSetOut_struct{
 namespace HSS_Time_Private {
 class TIMES_API CSunriseSunsetCalc
 {
+	friend class SolarPosition;
+
 public:
+	static constexpr double WTIME_EPOCH_JD = 2305447.5;		// julian day of 1600-01-01, where WTime counts from
+
 	CSunriseSunsetCalc();
 	~CSunriseSunsetCalc(){};
 	INTNM::int16_t calcSun(RISESET_IN_STRUCT &latLongForm, RISESET_OUT_STRUCT *riseSetForm);
 		#define NO_SUNRISE	0x0001
 		#define NO_SUNSET	0x0002
+	void calcSunBatch(INTNM::int32_t year, INTNM::int32_t month, INTNM::int32_t day, const double *latitude, const double *longitude, std::size_t count,
+		double *riseUTC, double *setUTC, double *noonUTC, INTNM::int16_t *flags);
 	static bool isLeapYear(INTNM::int32_t yr); 
 
 private:
@@ -87,11 +94,15 @@ private:
 	double calcSunRtAscension(double t);
 	double calcSunDeclination(double t);
 	double calcEquationOfTime(double t);
+	void calcSunEphemeris(double t, double *eqTime, double *solarDec);
+	void calcDayEphemeris(double jd, double *eqTime, double *solarDec);
 	double calcHourAngleSunrise(double lat, double solarDec);
 	double calcHourAngleSunset(double lat, double solarDec);
 	double calcSunriseUTC(double JD, double latitude, double longitude);
-	double calcSolNoonUTC(double t, double longitude);
+	double calcSolNoonUTC(double JD, double longitude);
 	double calcSunsetUTC(double JD, double latitude, double longitude);
+	INTNM::int32_t calcPolarDay(double jd, double latitude);
+	double findPolarBoundary(double jd, double latitude, double direction);
 	double findRecentSunrise(double jd, double latitude, double longitude);
 	double findRecentSunset(double jd, double latitude, double longitude);
 	double findNextSunrise(double jd, double latitude, double longitude);
@@ -21,9 +21,12 @@
 #include "times_internal.h"
 #include "worldlocation.h"
 #include "SunriseSunsetCalc.h"
+#include "CivilCalendar.h"
 #include "poly.gis.h"
 
+#include <atomic>
 #include <string>
+#include <string_view>
 
 
 #ifdef MSVC_COMPILER
@@ -73,6 +76,7 @@ namespace HSS_Time {
 #define WTIME_FORMAT_DAY_OF_WEEK		0x00000100	// prepend with day of week
 #define WTIME_FORMAT_ABBREV				0x00001000	// abbreviate the month, day of week
 #define WTIME_FORMAT_WITHDST			0x04000000
+#define WTIME_FORMAT_WITHHISTORY		0x08000000	// with WTIME_FORMAT_AS_LOCAL, use the offset the location's tzdb zone actually had at that time
 #define WTIME_FORMAT_PARSE_USING_SYSTEM	0x80000000	// if this is used, then we use the system parser which will use the locale settings, otherwise
 		// we use our own internal parser
 		//		#define WTIME_FORMAT_EXCLUDE_SECONDS	0x0100			// forget about sticking the seconds onto the end of the string
@@ -104,6 +108,7 @@ namespace HSS_Time {
 
 class TIMES_API WTimeSpan {
     friend class WTime;
+    friend class WTimePoint;
     private:
 	INTNM::int64_t m_timeSpan;
 
@@ -227,10 +232,59 @@ class TIMES_API WTimeManager {
 	static const char *days[7];
 
 	static const WTimeManager GetSystemTimeManager(WorldLocation& location);
+
+	WTimeManager(const WTimeManager &tm);
+
+    private:
+	friend class WTime;
+
+					// DST window of the last year that was asked about, as UTC instants so testing a time is two
+					// comparisons. It's a seqlock: m_dstSequence is odd while an entry is being written and readers
+					// retry the slow way if it changed under them. An entry is only good for the m_worldLocation
+					// generation it was built from.
+	mutable std::atomic<INTNM::uint32_t> m_dstSequence;
+	mutable std::atomic<INTNM::uint64_t> m_dstKey;			// (generation + 1) << 1 | inverted, 0 when empty
+	mutable std::atomic<INTNM::uint64_t> m_dstYearStart, m_dstYearEnd;
+	mutable std::atomic<INTNM::uint64_t> m_dstStart, m_dstEnd;
+
+	bool isDST(INTNM::uint64_t time) const;
+					// is DST in effect at a UTC time, in the location's standard time (WTIME_FORMAT_AS_LOCAL)
 };
                                                                                    
 
+struct WTimeFields {				// every calendar field of a WTime, worked out from a single timezone/DST adjustment by WTime::Decompose
+	INTNM::int32_t	m_year;
+	INTNM::int32_t	m_month;			// month of year (1 = Jan)
+	INTNM::int32_t	m_day;				// day of month
+	INTNM::int32_t	m_hour;
+	INTNM::int32_t	m_minute;
+	INTNM::int32_t	m_second;
+	INTNM::int32_t	m_microSeconds;
+	INTNM::int32_t	m_dayOfWeek;		// 1=Sun, 2=Mon, 3=Tues, 4=Wed, 5=Thurs, 6=Fri, 7=Sat
+	INTNM::int32_t	m_dayOfYear;		// Jan 1 = 1
+};
+
+
+struct WTimeColumns {				// structure of arrays filled by WTime::Decompose(times, count, ...), each needs room for count values
+	INTNM::int32_t	*m_year;
+	INTNM::int32_t	*m_month;			// month of year (1 = Jan)
+	INTNM::int32_t	*m_day;				// day of month
+	INTNM::int32_t	*m_hour;
+	INTNM::int32_t	*m_minute;
+	INTNM::int32_t	*m_second;
+	INTNM::int32_t	*m_dayOfYear;		// Jan 1 = 1
+};
+
+
+struct WTimeParseResult {			// what WTime::ParseDateTimes found across all of its rows
+	std::size_t		m_failed;			// rows that couldn't be parsed
+	INTNM::int64_t	m_step;				// microseconds between consecutive rows if every row parsed and they're evenly spaced, otherwise 0
+};
+
+
 class TIMES_API WTime {				// this value is always stored in GMT time!!! - unless you play with constructors or do it manually
+    friend class WTimePoint;
+    friend class WTimeRange;
 private:
 	INTNM::uint64_t		m_time;	// this is a count of microseconds since January 1, 1600.  This may seem like an arbritrary point in time (and it is), but there is some
 					// logic to this: the Gregorian calendar started on October 4, 1582:
@@ -248,6 +302,8 @@ private:
 	void construct_time_t(INTNM::int32_t nYear, INTNM::int32_t nMonth, INTNM::int32_t nDay, INTNM::int32_t nHour, INTNM::int32_t nMin, INTNM::int32_t nSec);
 	INTNM::uint64_t adjusted_tm(INTNM::uint32_t flags) const;
 	INTNM::uint64_t adjusted_tm_math(INTNM::uint32_t flags) const;
+	void setParsedDateTime(INTNM::int32_t year, INTNM::int32_t month, INTNM::int32_t day, INTNM::int32_t hour, INTNM::int32_t min, INTNM::int32_t sec,
+		const INTNM::int64_t *secondOffset, bool timezoneExists, INTNM::uint32_t flags, WorldLocation *location);
 #if defined(TIMES_WINDOWS) && !defined(_NO_MFC)
 	bool systemParseDateTime(const TCHAR *lpszDate, INTNM::uint32_t flags);
 #endif
@@ -313,6 +369,11 @@ public:
 	INTNM::uint64_t GetSecondsIntoYear(INTNM::uint32_t flags) const;
 	WTimeSpan GetWTimeSpanIntoYear(INTNM::uint32_t flags) const;
 	bool IsLeapYear(INTNM::uint32_t flags) const;
+	WTimeFields Decompose(INTNM::uint32_t flags) const;
+					// all of the above at once, every field is -1 if the time isn't set
+	static void Decompose(const INTNM::uint64_t *times, std::size_t count, const WTimeManager *tm, INTNM::uint32_t flags, const WTimeColumns &columns);
+					// the same for a column of times (microseconds since 1600, as GetTotalMicroSeconds returns), the calendar
+					// arithmetic is done on blocks of times at once so the compiler can vectorize it
 
  	void PurgeToSecond(INTNM::uint32_t flags);
 	void PurgeToMinute(INTNM::uint32_t flags);
@@ -344,8 +405,18 @@ public:
 #if defined(TIMES_WINDOWS) && !defined(_NO_MFC)
 	bool ParseDateTime(const CString &lpszDate, INTNM::uint32_t flags/* for timezone, DST */);
 #endif
-	bool ParseDateTime(const std::string &lpszDate, INTNM::uint32_t flags/* for timezone, DST */, WorldLocation* location = nullptr);
+	bool ParseDateTime(std::string_view lpszDate, INTNM::uint32_t flags/* for timezone, DST */, WorldLocation* location = nullptr);
+									// ISO 8601 dates and times (YYYY-MM-DD, then optionally Thh:mm[:ss], then optionally Z or +/-hh:mm) are read in
+									// a single pass without allocating when flags asks for WTIME_FORMAT_STRING_YYYYhMMhDD(T), everything else
+									// goes through the general parser
 	bool ParseDateTime(const std::wstring &lpszDate, INTNM::uint32_t flags/* for timezone, DST */);
+	static WTimeParseResult ParseDateTimes(const char *buffer, const std::size_t *offsets, std::size_t count, const WTimeManager *tm, INTNM::uint32_t flags,
+		INTNM::uint64_t *times, INTNM::uint64_t *failures = nullptr);
+									// a column of timestamps, such as the dates in a weather stream file, parsed in parallel.  Row i is
+									// buffer[offsets[i]] up to buffer[offsets[i + 1]] less any trailing whitespace, line end or comma, so
+									// offsets has count + 1 entries.  Each row is read as a new WTime(tm) would read it and times[i] gets
+									// its GetTotalMicroSeconds(), or -1 if it failed.  If given, failures needs (count + 63) / 64 words and
+									// bit (i % 64) of word (i / 64) is set for failed rows and cleared for the rest
 									// match_str
 #if defined(TIMES_WINDOWS) && !defined(_NO_MFC)
 	friend TIMES_API CArchive& AFXAPI operator<<(CArchive& ar, const WTime &time);
@@ -0,0 +1,97 @@
+/**
+ * TimezoneGrid.h
+ *
+ * Copyright 2016-2023 Heartland Software Solutions Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the license at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the LIcense is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "times_internal.h"
+#include "worldlocation.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+
+namespace HSS_Time {
+
+/// <summary>
+/// The timezones of a fixed latitude/longitude extent, rasterized into rows and columns of cells so that looking up a
+/// location inside it is a single array access. A cell is only answered from the grid when its corners and centre all
+/// resolve to the same timezone; cells that straddle a boundary are flagged as border cells and looked up exactly, as
+/// are locations outside of the extent.
+/// </summary>
+class TIMES_API TimezoneGrid {
+public:
+	TimezoneGrid();
+
+	/// <summary>
+	/// Rasterize an extent. Any previous contents are replaced.
+	/// </summary>
+	/// <param name="south">The southern edge of the extent (in radians).</param>
+	/// <param name="west">The western edge of the extent (in radians).</param>
+	/// <param name="north">The northern edge of the extent (in radians).</param>
+	/// <param name="east">The eastern edge of the extent (in radians).</param>
+	/// <param name="rows">The number of rows of cells, south to north.</param>
+	/// <param name="columns">The number of columns of cells, west to east.</param>
+	/// <param name="set">Whether we want back STD or DST timezones, as for WorldLocation::TimeZoneFromLatLon.</param>
+	/// <returns>False if the extent or the number of cells isn't valid, in which case the grid is left empty.</returns>
+	bool Build(double south, double west, double north, double east, std::uint32_t rows, std::uint32_t columns, INTNM::int16_t set);
+
+	/// <summary>
+	/// Get the timezone for a location. The answer is approximate: a cell whose corners and centre agree is answered from the
+	/// grid, so an enclave of another timezone that's smaller than a cell and misses those points isn't seen. Border cells
+	/// and locations outside the extent are looked up exactly, as WorldLocation::TimeZoneFromLatLon would.
+	/// </summary>
+	/// <param name="latitude">The locations latitude (in radians).</param>
+	/// <param name="longitude">The locations longitude (in radians).</param>
+	/// <param name="valid">If supplied, will be set to 1 if a timezone was found for the location, and 0 otherwise</param>
+	const TimeZoneInfo* Lookup(double latitude, double longitude, bool* valid = nullptr) const;
+
+	std::uint32_t Rows() const								{ return m_rows; }
+	std::uint32_t Columns() const							{ return m_columns; }
+	bool IsEmpty() const									{ return m_cells.empty(); }
+	bool IsBorder(std::uint32_t row, std::uint32_t column) const;
+	std::uint64_t BorderCount() const;
+
+	/// <summary>
+	/// Write the grid in a compact binary form that Load accepts. Timezones are stored by name so a grid can be reused by
+	/// later runs.
+	/// </summary>
+	bool Save(std::ostream& out) const;
+	/// <summary>
+	/// Read a grid written by Save.
+	/// </summary>
+	/// <returns>False if the data is damaged, from a different version, or names a timezone that can't be found, in which
+	/// case the grid is left empty.</returns>
+	bool Load(std::istream& in);
+
+private:
+	static constexpr std::uint32_t VERSION = 1;
+	static constexpr std::uint16_t BORDER = 0x8000;			// flag on a cell, look the location up exactly
+	static constexpr std::uint16_t NO_ZONE = 0x7fff;		// no timezone for the cell, as when valid is set to 0
+	static constexpr std::uint16_t ZONE_MASK = 0x7fff;
+
+	double m_south, m_west, m_latitudeStep, m_longitudeStep;
+	std::uint32_t m_rows, m_columns;
+	INTNM::int16_t m_set;
+	std::vector<const TimeZoneInfo*> m_zones;				// indexed by a cell's value
+	std::vector<std::uint16_t> m_cells;						// row major from the south west corner
+
+	void clear();
+};
+
+};
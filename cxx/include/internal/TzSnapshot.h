@@ -0,0 +1,120 @@
+/**
+ * TzSnapshot.h
+ *
+ * Copyright 2016-2023 Heartland Software Solutions Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the license at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the LIcense is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "times_internal.h"
+#include "worldlocation.h"
+#include "open/date/include/date/tz.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace HSS_Time_Private {
+
+///<summary>
+///Layout of a tzdb snapshot image. All offsets are in bytes from the start of the image, every table is 8 byte aligned,
+///and zones and links are sorted by name so they can be binary searched in place.
+///</summary>
+struct TzSnapshotHeader {
+	char			m_magic[8];				// "WTTZSNAP"
+	std::uint32_t	m_version;				// TzSnapshot::VERSION
+	std::uint32_t	m_zoneCount;
+	std::uint32_t	m_linkCount;
+	std::uint32_t	m_abbrevCount;
+	std::uint64_t	m_zones;				// TzSnapshotZone[m_zoneCount]
+	std::uint64_t	m_links;				// TzSnapshotLink[m_linkCount]
+	std::uint64_t	m_times;				// std::uint64_t[], every zone's m_times back to back
+	std::uint64_t	m_offsets;				// TimeZoneOffset[], in step with m_times
+	std::uint64_t	m_abbrevs;				// std::uint32_t[m_abbrevCount], string offsets
+	std::uint64_t	m_strings;				// nul terminated strings
+	char			m_tzdbVersion[16];
+};
+
+struct TzSnapshotZone {
+	std::uint32_t	m_name;					// string offset
+	std::uint32_t	m_first;				// index of the zone's first entry in m_times and m_offsets
+	std::uint32_t	m_count;
+	std::uint32_t	m_firstAbbrev;			// index of the zone's first entry in m_abbrevs
+	std::uint64_t	m_end;					// TimeZoneTransitions::m_end
+};
+
+struct TzSnapshotLink {
+	std::uint32_t	m_name;					// string offset
+	std::uint32_t	m_zone;					// index into the zones
+};
+
+
+class TIMES_API TzSnapshot {
+public:
+	static constexpr std::uint32_t VERSION = 2;
+
+	TzSnapshot();
+
+	///<summary>
+	///Attach to an image. Nothing is copied, the only work is validating the tables and fixing up the abbreviation pointers.
+	///The image compiled into the library is TimezoneMapper::snapshotImage.
+	///</summary>
+	///<returns>False if the image is damaged or from a different version, in which case the snapshot stays closed.</returns>
+	bool open(const void* image, std::size_t size);
+	bool isOpen() const									{ return m_header != nullptr; }
+	const char* tzdbVersion() const						{ return m_header ? m_header->m_tzdbVersion : nullptr; }
+
+	///<summary>
+	///Look up a zone or link by its (case sensitive) tzdb name.
+	///</summary>
+	///<param name="name">The zone or link name.</param>
+	///<param name="canonical">If supplied, receives the name of the zone, following links. It points into the image.</param>
+	///<param name="transitions">If supplied, receives the zone's transitions. They point into the image.</param>
+	bool find(std::string_view name, const char** canonical, HSS_Time::TimeZoneTransitions* transitions) const;
+
+	///<summary>
+	///Walk every sys_info the tzdb has for a zone from 1600 to horizon, merging neighbours that don't change anything, then
+	///drop the part of the table that only repeats the 400 years before it. This is used both to generate the snapshot and
+	///to build tables for zones it doesn't have.
+	///</summary>
+	///<returns>The zone's TimeZoneTransitions::m_end.</returns>
+	static std::uint64_t walk(const date::time_zone* tz, const date::sys_seconds& horizon, std::vector<std::uint64_t>& times,
+		std::vector<HSS_Time::TimeZoneOffset>& offsets, std::vector<std::string>& abbrevs);
+
+	///<summary>
+	///The earliest start of a year (from 2000 on) after which a zone's transitions, up to horizon, are the ones 400 years
+	///earlier again. A table that ends there loses nothing because TimeZoneTransitions::find repeats its last 400 years.
+	///</summary>
+	static std::uint64_t repeatingEnd(const std::uint64_t* times, const HSS_Time::TimeZoneOffset* offsets, std::size_t count,
+		std::uint64_t horizon);
+
+	///<summary>
+	///Serialize every zone and link in a tzdb into an image that open() accepts.
+	///</summary>
+	static std::vector<unsigned char> build(const date::tzdb& db);
+
+	static date::sys_seconds tableStart();
+	static date::sys_seconds tableEnd();				// how far the tzdb is walked, not where the tables end
+
+private:
+	const unsigned char*			m_image;
+	const TzSnapshotHeader*			m_header;
+	std::vector<const char*>		m_abbrevs;
+
+	const char* string(std::uint32_t offset) const		{ return (const char*)m_image + m_header->m_strings + offset; }
+};
+
+};
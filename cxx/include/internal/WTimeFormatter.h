@@ -0,0 +1,81 @@
+/**
+ * WTimeFormatter.h
+ *
+ * Copyright 2016-2023 Heartland Software Solutions Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the license at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the LIcense is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "times_internal.h"
+#include "worldlocation.h"
+#include "Times.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+namespace HSS_Time {
+
+/// <summary>
+/// Formats WTimes and WTimeSpans exactly as their ToString methods do for one set of WTIME_FORMAT_ flags, but without
+/// building std::strings or going through snprintf. The flags are decoded once, when the formatter is made, into a plan
+/// of the fields to write, so formatting a value is just the calendar arithmetic and writing digits. Make one formatter
+/// per column of output and reuse it, it's immutable so threads can share it.
+/// </summary>
+class TIMES_API WTimeFormatter {
+public:
+	/// <summary>
+	/// A buffer this long always holds a formatted time or time span and its terminating null.
+	/// </summary>
+	static constexpr std::size_t MAX_LENGTH = 128;
+
+	explicit WTimeFormatter(INTNM::uint32_t flags);
+
+	INTNM::uint32_t Flags() const noexcept					{ return m_flags; }
+
+	/// <summary>
+	/// Format a time as WTime::ToString(flags) would, with snprintf's conventions: at most size - 1 characters and a
+	/// terminating null are written.
+	/// </summary>
+	/// <returns>The length of the complete string, which is more than was written if buffer is too small.</returns>
+	std::size_t Format(const WTime &time, char *buffer, std::size_t size) const;
+	/// <summary>
+	/// Format a time span as WTimeSpan::ToString(flags) would, with snprintf's conventions.
+	/// </summary>
+	std::size_t Format(const WTimeSpan &span, char *buffer, std::size_t size) const;
+
+	/// <summary>
+	/// Append a formatted time or time span to a string, which only allocates if the string has to grow.
+	/// </summary>
+	void Append(const WTime &time, std::string &str) const;
+	void Append(const WTimeSpan &span, std::string &str) const;
+
+private:
+	static constexpr std::size_t MAX_PLAN = 32;
+
+	INTNM::uint32_t m_flags;
+	std::uint8_t m_plan[MAX_PLAN];						// opcodes from the .cpp, some followed by an operand byte
+	std::uint8_t m_planLength;
+	const char * const *m_months;						// full or abbreviated names
+	const char * const *m_days;
+
+	void emit(std::uint8_t op);
+	void emit(std::uint8_t op, std::uint8_t operand);
+	char *write(const WTime &time, char *p) const;		// p has room for MAX_LENGTH characters, returns the end
+	char *write(const WTimeSpan &span, char *p) const;
+};
+
+};
@@ -0,0 +1,97 @@
+/**
+ * WTimePoint.h
+ *
+ * Copyright 2016-2023 Heartland Software Solutions Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the license at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the LIcense is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "times_internal.h"
+#include "worldlocation.h"
+#include "Times.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+
+
+namespace HSS_Time {
+
+/// <summary>
+/// A point in time without a WTimeManager, for storing long series of times where every entry shares the same manager.
+/// It's the same count of microseconds since January 1, 1600 that WTime keeps, so it's 8 bytes, trivially copyable, and
+/// converting to and from a WTime is a copy. As with WTime, a time of -1 is unset and adding to or subtracting from it
+/// leaves it unset. Unlike WTime, comparisons are on the raw count so they're a strict weak ordering with unset times
+/// sorting last, which is what sorted containers and Sort need.
+/// </summary>
+class TIMES_API WTimePoint {
+public:
+	WTimePoint() = default;												// uninitialized, like an int
+	constexpr explicit WTimePoint(INTNM::uint64_t microSeconds) noexcept : m_time(microSeconds) { }
+	explicit WTimePoint(const WTime &time) noexcept : m_time(time.m_time) { }
+
+	static constexpr WTimePoint Unset() noexcept						{ return WTimePoint((INTNM::uint64_t)-1); }
+
+	/// <summary>
+	/// The time as a WTime that uses a time manager.
+	/// </summary>
+	WTime ToWTime(const WTimeManager *tm) const							{ return WTime(m_time, tm, false); }
+
+	constexpr bool IsValid() const noexcept								{ return m_time != (INTNM::uint64_t)-1; }
+	constexpr INTNM::uint64_t GetTotalMicroSeconds() const noexcept		{ return m_time; }
+	constexpr INTNM::uint64_t GetTotalSeconds() const noexcept			{ return IsValid() ? m_time / 1000000LL : m_time; }
+
+	// time math
+	WTimePoint operator+(const WTimeSpan &timeSpan) const noexcept		{ return IsValid() ? WTimePoint(m_time + timeSpan.m_timeSpan) : *this; }
+	WTimePoint operator-(const WTimeSpan &timeSpan) const noexcept		{ return IsValid() ? WTimePoint(m_time - timeSpan.m_timeSpan) : *this; }
+	WTimePoint& operator+=(const WTimeSpan &timeSpan) noexcept			{ if (IsValid()) m_time += timeSpan.m_timeSpan; return *this; }
+	WTimePoint& operator-=(const WTimeSpan &timeSpan) noexcept			{ if (IsValid()) m_time -= timeSpan.m_timeSpan; return *this; }
+	WTimeSpan operator-(const WTimePoint &time) const					{ return IsValid() ? WTimeSpan((INTNM::int64_t)(m_time - time.m_time), false) : WTimeSpan(-1, false); }
+
+	constexpr bool operator==(const WTimePoint &time) const noexcept	{ return m_time == time.m_time; }
+	constexpr bool operator!=(const WTimePoint &time) const noexcept	{ return m_time != time.m_time; }
+	constexpr bool operator<(const WTimePoint &time) const noexcept		{ return m_time < time.m_time; }
+	constexpr bool operator>(const WTimePoint &time) const noexcept		{ return m_time > time.m_time; }
+	constexpr bool operator<=(const WTimePoint &time) const noexcept	{ return m_time <= time.m_time; }
+	constexpr bool operator>=(const WTimePoint &time) const noexcept	{ return m_time >= time.m_time; }
+
+	/// <summary>
+	/// Sort times into ascending order with a least significant digit radix sort, 16 bits at a time. Digits that are
+	/// the same for every time (the high bits of a series that covers a few years) are skipped, so a typical series
+	/// takes 2 or 3 passes.
+	/// </summary>
+	/// <param name="times">The times to sort.</param>
+	/// <param name="count">The number of times.</param>
+	static void Sort(WTimePoint *times, std::size_t count);
+
+private:
+	INTNM::uint64_t m_time;												// microseconds since January 1, 1600, as WTime::m_time
+};
+
+static_assert(sizeof(WTimePoint) == sizeof(INTNM::uint64_t), "WTimePoint should be stored as densely as its count");
+static_assert(std::is_trivially_copyable<WTimePoint>::value, "WTimePoint should be copyable with memcpy");
+
+};
+
+
+namespace std {
+template<>
+struct hash<HSS_Time::WTimePoint> {
+	std::size_t operator()(const HSS_Time::WTimePoint &time) const noexcept {
+		return std::hash<INTNM::uint64_t>()(time.GetTotalMicroSeconds());
+	}
+};
+};
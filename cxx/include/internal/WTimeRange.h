@@ -0,0 +1,138 @@
+/**
+ * WTimeRange.h
+ *
+ * Copyright 2016-2023 Heartland Software Solutions Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the license at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the LIcense is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "times_internal.h"
+#include "worldlocation.h"
+#include "Times.h"
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+
+namespace HSS_Time {
+
+/// <summary>
+/// The times from a start time up to (but not including) an end time, a fixed step apart, for use in range based for
+/// loops and standard algorithms (including the parallel ones, the iterators are random access). Nothing is allocated
+/// while iterating and every time is worked out from its index, so iterators can be handed to different threads.
+///
+/// With WTIME_FORMAT_AS_LOCAL or WTIME_FORMAT_AS_SOLAR the times fall on step boundaries of local (or solar) time
+/// instead: each day starts at local midnight, even when DST makes a day 23 or 25 hours long. That's what PurgeToDay gives
+/// for a time before the day's DST change, after it PurgeToDay is out by the change.
+/// The offset to local time is worked out once per time when the range is built and kept as runs of equal offsets, so
+/// a range in local standard or daylight time keeps a handful of entries.
+///
+/// The iterators are proxy iterators: dereferencing one makes a WTime, so reference is a WTime value rather than a
+/// WTime&, and there's no pointer type. Strictly that only meets the C++17 input iterator requirements even though the
+/// tag says random access. The standard library's algorithms, including std::execution::par, accept them in practice,
+/// but an algorithm that writes through the iterator or keeps the address of *it won't work.
+/// </summary>
+class TIMES_API WTimeRange {
+public:
+	class iterator {
+	public:
+		typedef std::random_access_iterator_tag iterator_category;
+		typedef WTime value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef void pointer;
+		typedef WTime reference;				// times are made as they're asked for
+
+		iterator() noexcept : m_range(nullptr), m_index(0) { }
+		iterator(const WTimeRange *range, std::ptrdiff_t index) noexcept : m_range(range), m_index(index) { }
+
+		WTime operator*() const											{ return (*m_range)[(std::size_t)m_index]; }
+		WTime operator[](difference_type n) const						{ return (*m_range)[(std::size_t)(m_index + n)]; }
+
+		iterator& operator++() noexcept									{ m_index++; return *this; }
+		iterator operator++(int) noexcept								{ iterator i(*this); m_index++; return i; }
+		iterator& operator--() noexcept									{ m_index--; return *this; }
+		iterator operator--(int) noexcept								{ iterator i(*this); m_index--; return i; }
+		iterator& operator+=(difference_type n) noexcept				{ m_index += n; return *this; }
+		iterator& operator-=(difference_type n) noexcept				{ m_index -= n; return *this; }
+		iterator operator+(difference_type n) const noexcept			{ return iterator(m_range, m_index + n); }
+		iterator operator-(difference_type n) const noexcept			{ return iterator(m_range, m_index - n); }
+		friend iterator operator+(difference_type n, const iterator &i) noexcept	{ return i + n; }
+		difference_type operator-(const iterator &i) const noexcept		{ return m_index - i.m_index; }
+
+		bool operator==(const iterator &i) const noexcept				{ return m_index == i.m_index; }
+		bool operator!=(const iterator &i) const noexcept				{ return m_index != i.m_index; }
+		bool operator<(const iterator &i) const noexcept				{ return m_index < i.m_index; }
+		bool operator>(const iterator &i) const noexcept				{ return m_index > i.m_index; }
+		bool operator<=(const iterator &i) const noexcept				{ return m_index <= i.m_index; }
+		bool operator>=(const iterator &i) const noexcept				{ return m_index >= i.m_index; }
+
+	private:
+		const WTimeRange *m_range;
+		std::ptrdiff_t m_index;
+	};
+	typedef iterator const_iterator;
+
+	/// <summary>
+	/// Every step from begin (inclusive) to end (exclusive).
+	/// </summary>
+	WTimeRange(const WTime &begin, const WTime &end, const WTimeSpan &step);
+	/// <summary>
+	/// Every step from begin (inclusive) to end (exclusive), where the step is one of the ITERATION_ values for
+	/// WTimeManager::TimeForIndex. If flags has WTIME_FORMAT_AS_LOCAL or WTIME_FORMAT_AS_SOLAR (and optionally
+	/// WTIME_FORMAT_WITHDST), the times are aligned to the step in that time, starting with the first one at or after begin.
+	/// </summary>
+	WTimeRange(const WTime &begin, const WTime &end, INTNM::int32_t iteration, INTNM::uint32_t flags);
+
+	std::size_t Size() const noexcept									{ return m_count; }
+	bool IsEmpty() const noexcept										{ return m_count == 0; }
+	WTimeSpan Step() const												{ return WTimeSpan(m_step, false); }
+	const WTimeManager *GetTimeManager() const noexcept					{ return m_tm; }
+
+	/// <summary>
+	/// The index'th time in the range, index must be less than Size().
+	/// </summary>
+	WTime operator[](std::size_t index) const							{ return WTime(at(index), m_tm, false); }
+
+	iterator begin() const noexcept										{ return iterator(this, 0); }
+	iterator end() const noexcept										{ return iterator(this, (std::ptrdiff_t)m_count); }
+
+private:
+	struct Run {
+		std::size_t		m_first;				// index of the first time that uses m_adjust
+		INTNM::int64_t	m_adjust;				// added to m_start + index * m_step
+	};
+
+	const WTimeManager *m_tm;
+	INTNM::uint64_t m_start;
+	INTNM::int64_t m_step;
+	std::size_t m_count;
+	std::vector<Run> m_runs;					// empty unless the range is aligned to local or solar time
+
+	INTNM::uint64_t at(std::size_t index) const noexcept {
+		INTNM::uint64_t time = m_start + (INTNM::uint64_t)index * (INTNM::uint64_t)m_step;
+		if (m_runs.empty())
+			return time;
+		std::size_t lo = 0, n = m_runs.size();
+		while (n > 1) {							// last run starting at or before index
+			std::size_t half = n / 2;
+			lo = (m_runs[lo + half].m_first <= index) ? lo + half : lo;
+			n -= half;
+		}
+		return time + m_runs[lo].m_adjust;
+	}
+};
+
+};
@@ -0,0 +1,261 @@
+/**
+ * WTimeSeries.h
+ *
+ * Copyright 2016-2023 Heartland Software Solutions Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the license at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the LIcense is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "times_internal.h"
+#include "worldlocation.h"
+#include "Times.h"
+#include "WTimePoint.h"
+
+#include <cstddef>
+#include <vector>
+
+
+namespace HSS_Time {
+
+/// <summary>
+/// A read only window onto a run of a WTimeSeries (or any sorted array of times with values alongside), answering the
+/// same queries as the series. It points into the series' storage so it's only good until the series is changed.
+/// Indices are relative to the start of the view.
+/// </summary>
+template<typename T>
+class WTimeSeriesView {
+public:
+	static constexpr std::size_t npos = (std::size_t)-1;
+
+	WTimeSeriesView() noexcept : m_times(nullptr), m_values(nullptr), m_count(0), m_step(0), m_tm(nullptr) { }
+	/// <summary>
+	/// View count times (ascending microseconds since 1600) and their values.
+	/// </summary>
+	/// <param name="step">The time between consecutive entries if they're evenly spaced, 0 if they're not (or unknown).</param>
+	WTimeSeriesView(const INTNM::uint64_t *times, const T *values, std::size_t count, INTNM::uint64_t step, const WTimeManager *tm) noexcept
+		: m_times(times), m_values(values), m_count(count), m_step(step), m_tm(tm) { }
+
+	std::size_t Size() const noexcept							{ return m_count; }
+	bool IsEmpty() const noexcept								{ return m_count == 0; }
+	const WTimeManager *GetTimeManager() const noexcept			{ return m_tm; }
+
+	WTime Time(std::size_t index) const							{ return WTime(m_times[index], m_tm, false); }
+	WTimePoint Point(std::size_t index) const noexcept			{ return WTimePoint(m_times[index]); }
+	const T& Value(std::size_t index) const noexcept			{ return m_values[index]; }
+	const INTNM::uint64_t *Times() const noexcept				{ return m_times; }
+	const T *Values() const noexcept							{ return m_values; }
+
+	/// <summary>
+	/// Whether the entries are evenly spaced, so looking up a time is arithmetic rather than a search.
+	/// </summary>
+	bool IsRegular() const noexcept								{ return (m_step != 0) || (m_count < 2); }
+	/// <summary>
+	/// The time between entries of a regular series, or 0.
+	/// </summary>
+	WTimeSpan Step() const										{ return WTimeSpan((INTNM::int64_t)m_step, false); }
+	/// <summary>
+	/// The ITERATION_ value (from WTimeManager::TimeForIndex) that matches the step of a regular series, or -1 if the
+	/// series isn't regular or its step isn't one of them.
+	/// </summary>
+	INTNM::int32_t Cadence() const {
+		if (!m_step)
+			return -1;
+		WTimeSpan step = Step();
+		INTNM::int32_t index = WTimeManager::IterationIndex(step);
+		return (WTimeManager::TimeForIndex(index) == step) ? index : -1;
+	}
+
+	/// <summary>
+	/// The index of the entry at exactly this time, or npos. Every query answers npos for a time that isn't set.
+	/// </summary>
+	std::size_t Find(const WTime &time) const noexcept			{ return findIndex(time.GetTotalMicroSeconds()); }
+	std::size_t Find(WTimePoint time) const noexcept			{ return findIndex(time.GetTotalMicroSeconds()); }
+	/// <summary>
+	/// The index of the last entry at or before this time, or npos if every entry is later.
+	/// </summary>
+	std::size_t Floor(const WTime &time) const noexcept			{ return floorIndex(time.GetTotalMicroSeconds()); }
+	std::size_t Floor(WTimePoint time) const noexcept			{ return floorIndex(time.GetTotalMicroSeconds()); }
+	/// <summary>
+	/// The index of the first entry at or after this time, or npos if every entry is earlier.
+	/// </summary>
+	std::size_t Ceil(const WTime &time) const noexcept			{ return ceilIndex(time.GetTotalMicroSeconds()); }
+	std::size_t Ceil(WTimePoint time) const noexcept			{ return ceilIndex(time.GetTotalMicroSeconds()); }
+	/// <summary>
+	/// The index of the entry closest to this time, the earlier one on a tie, or npos if the view is empty.
+	/// </summary>
+	std::size_t Nearest(const WTime &time) const noexcept		{ return nearestIndex(time.GetTotalMicroSeconds()); }
+	std::size_t Nearest(WTimePoint time) const noexcept			{ return nearestIndex(time.GetTotalMicroSeconds()); }
+
+	/// <summary>
+	/// The entries from start up to but not including end, without copying them.
+	/// </summary>
+	WTimeSeriesView Slice(const WTime &start, const WTime &end) const noexcept {
+		return slice(lowerBound(start.GetTotalMicroSeconds()), lowerBound(end.GetTotalMicroSeconds()));
+	}
+	/// <summary>
+	/// The entries from index first up to but not including index last, which are clamped to the view.
+	/// </summary>
+	WTimeSeriesView Slice(std::size_t first, std::size_t last) const noexcept {
+		if (last > m_count)
+			last = m_count;
+		return slice(first, last);
+	}
+
+protected:
+	const INTNM::uint64_t *m_times;
+	const T *m_values;
+	std::size_t m_count;
+	INTNM::uint64_t m_step;
+	const WTimeManager *m_tm;
+
+	// index of the first entry at or after time (INCLUSIVE == false), or after it (INCLUSIVE == true), m_count if none
+	template<bool INCLUSIVE>
+	std::size_t bound(INTNM::uint64_t time) const noexcept {
+		if (!m_count)
+			return 0;
+		if (time <= m_times[0])
+			return ((time == m_times[0]) && INCLUSIVE) ? 1 : 0;
+		if (m_step) {
+			const INTNM::uint64_t offset = time - m_times[0];
+			INTNM::uint64_t index = offset / m_step;
+			if (index >= m_count)
+				return m_count;
+			if ((offset % m_step) || INCLUSIVE)
+				index++;
+			return (std::size_t)index;
+		}
+		// branch free binary search, the conditional is a select rather than a jump
+		const INTNM::uint64_t *base = m_times;
+		std::size_t n = m_count;
+		while (n > 1) {
+			const std::size_t half = n / 2;
+			base = (INCLUSIVE ? (base[half - 1] <= time) : (base[half - 1] < time)) ? base + half : base;
+			n -= half;
+		}
+		return (std::size_t)(base - m_times) + ((INCLUSIVE ? (*base <= time) : (*base < time)) ? 1 : 0);
+	}
+	std::size_t lowerBound(INTNM::uint64_t time) const noexcept		{ return bound<false>(time); }
+	std::size_t upperBound(INTNM::uint64_t time) const noexcept		{ return bound<true>(time); }
+
+	std::size_t findIndex(INTNM::uint64_t time) const noexcept {
+		if (time == (INTNM::uint64_t)-1)
+			return npos;
+		std::size_t index = lowerBound(time);
+		return ((index < m_count) && (m_times[index] == time)) ? index : npos;
+	}
+	std::size_t floorIndex(INTNM::uint64_t time) const noexcept {
+		if (time == (INTNM::uint64_t)-1)
+			return npos;
+		std::size_t index = upperBound(time);
+		return index ? index - 1 : npos;
+	}
+	std::size_t ceilIndex(INTNM::uint64_t time) const noexcept {
+		if (time == (INTNM::uint64_t)-1)
+			return npos;
+		std::size_t index = lowerBound(time);
+		return (index < m_count) ? index : npos;
+	}
+	std::size_t nearestIndex(INTNM::uint64_t time) const noexcept {
+		if ((!m_count) || (time == (INTNM::uint64_t)-1))
+			return npos;
+		std::size_t index = lowerBound(time);
+		if (index == m_count)
+			return m_count - 1;
+		if ((index == 0) || (m_times[index] == time))
+			return index;
+		return ((time - m_times[index - 1]) <= (m_times[index] - time)) ? index - 1 : index;
+	}
+	WTimeSeriesView slice(std::size_t first, std::size_t last) const noexcept {
+		if (first >= last)
+			return WTimeSeriesView(m_times, m_values, 0, m_step, m_tm);
+		return WTimeSeriesView(m_times + first, m_values + first, last - first, m_step, m_tm);
+	}
+};
+
+
+/// <summary>
+/// Values recorded at a sequence of times that share a time manager, such as hourly weather. Times and values are kept
+/// in separate contiguous arrays so scanning either doesn't drag the other through the cache, and the raw times can be
+/// handed straight to WTime::Decompose. The series notices when its times are evenly spaced (hourly, daily, ...) and then
+/// finds a time by arithmetic, otherwise by a binary search.
+/// </summary>
+template<typename T>
+class WTimeSeries {
+public:
+	typedef WTimeSeriesView<T> View;
+	static constexpr std::size_t npos = View::npos;
+
+	explicit WTimeSeries(const WTimeManager *tm) noexcept : m_tm(tm), m_step(0) { }
+
+	/// <summary>
+	/// Add an entry to the end of the series.
+	/// </summary>
+	/// <returns>False (and the entry isn't added) if the time isn't later than the last entry's, or isn't set.</returns>
+	bool Append(const WTime &time, const T &value)				{ return Append(WTimePoint(time), value); }
+	bool Append(WTimePoint time, const T &value) {
+		const INTNM::uint64_t t = time.GetTotalMicroSeconds();
+		if ((!time.IsValid()) || ((!m_times.empty()) && (t <= m_times.back())))
+			return false;
+		if (m_times.size() == 1)
+			m_step = t - m_times[0];
+		else if ((m_step) && (t - m_times.back() != m_step))
+			m_step = 0;
+		m_times.push_back(t);
+		m_values.push_back(value);
+		return true;
+	}
+	void Reserve(std::size_t count)								{ m_times.reserve(count); m_values.reserve(count); }
+	void Clear() noexcept										{ m_times.clear(); m_values.clear(); m_step = 0; }
+
+	std::size_t Size() const noexcept							{ return m_times.size(); }
+	bool IsEmpty() const noexcept								{ return m_times.empty(); }
+	const WTimeManager *GetTimeManager() const noexcept			{ return m_tm; }
+
+	WTime Time(std::size_t index) const							{ return WTime(m_times[index], m_tm, false); }
+	WTimePoint Point(std::size_t index) const noexcept			{ return WTimePoint(m_times[index]); }
+	const T& Value(std::size_t index) const noexcept			{ return m_values[index]; }
+	T& Value(std::size_t index) noexcept						{ return m_values[index]; }
+	const INTNM::uint64_t *Times() const noexcept				{ return m_times.data(); }
+	const T *Values() const noexcept							{ return m_values.data(); }
+	T *Values() noexcept										{ return m_values.data(); }
+
+	/// <summary>
+	/// The whole series as a view, which answers all of the queries below.
+	/// </summary>
+	View AsView() const noexcept								{ return View(m_times.data(), m_values.data(), m_times.size(), m_step, m_tm); }
+
+	bool IsRegular() const noexcept								{ return AsView().IsRegular(); }
+	WTimeSpan Step() const										{ return AsView().Step(); }
+	INTNM::int32_t Cadence() const								{ return AsView().Cadence(); }
+
+	std::size_t Find(const WTime &time) const noexcept			{ return AsView().Find(time); }
+	std::size_t Find(WTimePoint time) const noexcept			{ return AsView().Find(time); }
+	std::size_t Floor(const WTime &time) const noexcept			{ return AsView().Floor(time); }
+	std::size_t Floor(WTimePoint time) const noexcept			{ return AsView().Floor(time); }
+	std::size_t Ceil(const WTime &time) const noexcept			{ return AsView().Ceil(time); }
+	std::size_t Ceil(WTimePoint time) const noexcept			{ return AsView().Ceil(time); }
+	std::size_t Nearest(const WTime &time) const noexcept		{ return AsView().Nearest(time); }
+	std::size_t Nearest(WTimePoint time) const noexcept			{ return AsView().Nearest(time); }
+	View Slice(const WTime &start, const WTime &end) const noexcept	{ return AsView().Slice(start, end); }
+	View Slice(std::size_t first, std::size_t last) const noexcept	{ return AsView().Slice(first, last); }
+
+private:
+	const WTimeManager *m_tm;
+	std::vector<INTNM::uint64_t> m_times;						// microseconds since 1600, strictly increasing
+	std::vector<T> m_values;
+	INTNM::uint64_t m_step;										// spacing of every entry so far, 0 once they aren't evenly spaced
+};
+
+};
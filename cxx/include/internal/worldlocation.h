@@ -32,6 +32,7 @@ namespace HSS_Time {
 #include <string>
 #include "validation_object.h"
 #include "hssconfig/config.h"
+#include "SunCache.h"
 #ifdef HSS_USE_CACHING
 #include "valuecache_mt.h"
 #include "objectcache_mt.h"
@@ -54,12 +55,39 @@ namespace HSS_Time {
 #endif
 
 
+struct TIMES_API TimeZoneOffset {
+	INTNM::int32_t	m_offset;			// total offset from UTC in seconds, including m_save
+	INTNM::int16_t	m_save;				// the daylight savings portion of m_offset in seconds
+	INTNM::uint16_t	m_abbrev;			// index into TimeZoneTransitions::m_abbrevs
+};
+
+
+///<summary>
+///Every change in UTC offset a tzdb zone makes, from the start of WTime (1600) on. The table is built from the tzdb once,
+///when the zone is first resolved, and is never freed.
+///</summary>
+struct TIMES_API TimeZoneTransitions {
+	std::uint32_t			m_count;
+	const INTNM::uint64_t	*m_times;	// sorted UTC instants (microseconds since 1600, like WTime) each offset takes effect, m_times[0] is 0
+	const TimeZoneOffset	*m_offsets;
+	const char * const		*m_abbrevs;
+	INTNM::uint64_t			m_end;		// the table is exact to here, later times repeat the table's last 400 years
+
+	///<summary>
+	///Find the offset in effect at a UTC time, by binary search.
+	///</summary>
+	///<param name="time">The UTC time in microseconds since 1600.</param>
+	const TimeZoneOffset& find(INTNM::uint64_t time) const;
+};
+
+
 struct TIMES_API TimeZoneInfo {
 	WTimeSpan	m_timezone;
 	WTimeSpan	m_dst;
 	const char	*m_code;
 	const char	*m_name;
 	std::uint32_t m_id;
+	const TimeZoneTransitions *m_transitions;	// only set for tzdb zones, the std/dst/mil tables leave it null
 };
 
 
@@ -73,6 +101,7 @@ public:
 									// if you want to disable DST, then just set these to the same value
 				_amtDST;			// amount to adjust for DST
 	const TimeZoneInfo* _timezoneInfo;
+	INTNM::uint32_t	_generation;		// changes whenever the timezone or DST fields do, so WTimeManager knows when its DST cache is stale
 
 public:
 	 ///<summary>
@@ -103,12 +132,12 @@ public:
 	///<summary>
 	///Set the timezone offset for the world location. Clears the timezone if there is one.
 	///</summary>
-	inline void m_timezone(const WTimeSpan& value) { _timezoneInfo = nullptr; __timezone = value; }
+	inline void m_timezone(const WTimeSpan& value) { _timezoneInfo = nullptr; __timezone = value; _generation++; }
 
 	///<summary>
 	///Set the timezone offset for the world location. Clears the timezone if there is one.
 	///</summary>
-	inline void m_timezone(WTimeSpan&& value) { _timezoneInfo = nullptr; __timezone = std::move(value); }
+	inline void m_timezone(WTimeSpan&& value) { _timezoneInfo = nullptr; __timezone = std::move(value); _generation++; }
 
 	///<summary>
 	///Retrieve the time that DST begins for the current timezone.
@@ -118,12 +147,12 @@ public:
 	///<summary>
 	///Set the time that DST begins for the current timezone. Clears the timezone if there is one.
 	///</summary>
-	inline void m_startDST(const WTimeSpan& value) { _timezoneInfo = nullptr; _startDST = value; }
+	inline void m_startDST(const WTimeSpan& value) { _timezoneInfo = nullptr; _startDST = value; _generation++; }
 
 	///<summary>
 	///Set the time that DST begins for the current timezone. Clears the timezone if there is one.
 	///</summary>
-	inline void m_startDST(WTimeSpan&& value) { _timezoneInfo = nullptr; _startDST = std::move(value); }
+	inline void m_startDST(WTimeSpan&& value) { _timezoneInfo = nullptr; _startDST = std::move(value); _generation++; }
 
 	///<summary>
 	///Retrieve the time that DST ends for the current timezone.
@@ -133,12 +162,12 @@ public:
 	///<summary>
 	///Set the time that DST ends for the current timezone. Clears the timezone if there is one.
 	///</summary>
-	inline void m_endDST(const WTimeSpan& value) { _timezoneInfo = nullptr; _endDST = value; }
+	inline void m_endDST(const WTimeSpan& value) { _timezoneInfo = nullptr; _endDST = value; _generation++; }
 
 	///<summary>
 	///Set the time that DST ends for the current timezone. Clears the timezone if there is one.
 	///</summary>
-	inline void m_endDST(WTimeSpan&& value) { _timezoneInfo = nullptr; _endDST = std::move(value); }
+	inline void m_endDST(WTimeSpan&& value) { _timezoneInfo = nullptr; _endDST = std::move(value); _generation++; }
 
 	///<summary>
 	///Retrieve the offset that is applied to the time during DST.
@@ -148,12 +177,12 @@ public:
 	///<summary>
 	///Set the offset that is applied to the time during DST. Clears the timezone if there is one.
 	///</summary>
-	inline void m_amtDST(const WTimeSpan& value) { _timezoneInfo = nullptr; _amtDST = value; }
+	inline void m_amtDST(const WTimeSpan& value) { _timezoneInfo = nullptr; _amtDST = value; _generation++; }
 
 	///<summary>
 	///Set the offset that is applied to the time during DST. Clears the timezone if there is one.
 	///</summary>
-	inline void m_amtDST(WTimeSpan&& value) { _timezoneInfo = nullptr; _amtDST = std::move(value); }
+	inline void m_amtDST(WTimeSpan&& value) { _timezoneInfo = nullptr; _amtDST = std::move(value); _generation++; }
 
 	///<summary>
 	///Retrieve the timezone that was used to create this world location. May be null
@@ -179,6 +208,43 @@ public:
 							// any time during the local "solar" day will glean the right times - suggestion is to use local noon time
 	INTNM::int16_t m_sun_rise_set(double latitude, double longitude, const WTime& local_day, WTime* Rise, WTime* Set, WTime* Noon) const;
 	// any time during the local "solar" day will glean the right times - suggestion is to use local noon time
+	///<summary>
+	///Sunrise, sunset and solar noon for an array of positions on the same solar day (this location's, as for the single
+	///position versions), bypassing the sun cache. Positions in polar day or night get NO_SUNRISE and/or NO_SUNSET and a
+	///time of 0 rather than the nearest rise or set on another day.
+	///</summary>
+	///<param name="latitude">The positions latitudes (in radians).</param>
+	///<param name="longitude">The positions longitudes (in radians).</param>
+	///<param name="count">The number of positions.</param>
+	///<param name="local_day">Any time during the solar day.</param>
+	///<param name="rise">Receives count sunrise times, in microseconds since 1600 UTC.</param>
+	///<param name="set">Receives count sunset times, in microseconds since 1600 UTC.</param>
+	///<param name="noon">Receives count solar noon times, in microseconds since 1600 UTC.</param>
+	///<param name="success">Receives count flags, as m_sun_rise_set returns.</param>
+	void m_sun_rise_set(const double* latitude, const double* longitude, std::size_t count, const WTime& local_day,
+		INTNM::uint64_t* rise, INTNM::uint64_t* set, INTNM::uint64_t* noon, INTNM::int16_t* success) const;
+	///<summary>
+	///The sun's position over this location at a time. To step along a time series use a HSS_Time_Private::SolarPosition,
+	///which keeps the day's terms between calls.
+	///</summary>
+	///<param name="time">The time.</param>
+	///<param name="elevation">Receives the geometric elevation above the horizon, in radians.</param>
+	///<param name="azimuth">Receives the azimuth clockwise from north, in radians.</param>
+	void m_sun_position(const WTime& time, double* elevation, double* azimuth) const;
+
+	///<summary>
+	///Set how many solar days (per position) of m_sun_rise_set results are kept, 16 by default. 0 turns the cache off.
+	///Changing it empties the cache.
+	///</summary>
+	void SetSunCacheCapacity(std::size_t capacity) { m_sunCache.SetCapacity(capacity); }
+	///<summary>
+	///Get the number of m_sun_rise_set calls that were answered from, and that missed, the cache.
+	///</summary>
+	void GetSunCacheStatistics(std::uint64_t* hits, std::uint64_t* misses) const { m_sunCache.Statistics(hits, misses); }
+	///<summary>
+	///Empty the sunrise/sunset cache and reset its statistics.
+	///</summary>
+	void ClearSunCache() const { m_sunCache.Clear(); }
 
 public:
 	WorldLocation();
@@ -275,6 +341,18 @@ public:
 	///<param name="valid">If supplied, will be set to 1 if a timezone was found for the corresponding location, and 0 otherwise</param>
 	static const TimeZoneInfo* TimeZoneFromLatLon(const double latitude, const double longitude, INTNM::int16_t set, bool* valid = nullptr);
 	///<summary>
+	///Get the TimeZoneInfo objects for an array of latitude/longitude pairs, as for the single point version. Duplicate and
+	///near duplicate (within a micro-degree) points are only resolved once, and the distinct points are resolved in parallel.
+	///A point whose lookup fails with an exception gets a null timezone and a 0 in valid, the rest are still resolved.
+	///</summary>
+	///<param name="latitude">The locations latitudes (in radians).</param>
+	///<param name="longitude">The locations longitudes (in radians).</param>
+	///<param name="count">The number of locations.</param>
+	///<param name="set">Whether we want back STD or DST timezones</param>
+	///<param name="timezones">Receives count timezones, one for each location.</param>
+	///<param name="valid">If supplied, receives count flags, set to 1 if a timezone was found for the corresponding location, and 0 otherwise</param>
+	static void TimeZoneFromLatLon(const double* latitude, const double* longitude, std::size_t count, INTNM::int16_t set, const TimeZoneInfo** timezones, bool* valid = nullptr);
+	///<summary>
 	///Get a TimeZoneInfo object with the timezone data set correctly for the given location name. If the area uses
 	///daylight savings time at any point in the year it will be enabled.
 	///</summary>
@@ -298,6 +376,46 @@ public:
 	/// <returns>A standard timezone, or <paramref name="info"/> if one doesn't exist.</returns>
 	static const TimeZoneInfo* GetStandardTimeZone(const TimeZoneInfo* info);
 
+	/// <summary>
+	/// Set the size of the tiles used to cache the results of <see cref="TimeZoneFromLatLon"/> and <see cref="FromLatLon"/>.
+	/// A tile is only cached when the whole tile is known to be inside a single timezone.
+	/// </summary>
+	/// <param name="degrees">The tile size in degrees, clamped to between 0.001 and 10. 0 disables the cache.</param>
+	static void SetTimeZoneTileResolution(double degrees);
+	/// <summary>
+	/// Get the size, in degrees, of the timezone tile cache's tiles. 0 if the cache is disabled.
+	/// </summary>
+	static double GetTimeZoneTileResolution();
+	/// <summary>
+	/// Get the number of lookups that were answered from, and that missed, the timezone tile cache.
+	/// </summary>
+	static void GetTimeZoneTileStatistics(std::uint64_t* hits, std::uint64_t* misses);
+	/// <summary>
+	/// Empty the timezone tile cache and reset its statistics.
+	/// </summary>
+	static void ClearTimeZoneTileCache();
+	/// <summary>
+	/// Start opening the timezone databases on a background thread so the first timezone lookup doesn't have to. Lookups
+	/// made before it finishes wait for it rather than starting over. Only the first call has any effect, and it does
+	/// nothing if the databases are already open. Building with WTIME_AUTO_PREWARM calls this when the first WorldLocation
+	/// is constructed.
+	/// </summary>
+	static void PrewarmTimeZones();
+	/// <summary>
+	/// Wait for the background thread started by PrewarmTimeZones to finish. Call this before unloading the library, or
+	/// before the process exits, if a prewarm may still be running. The library doesn't join the thread itself during
+	/// static destruction because that can deadlock when it's a DLL.
+	/// </summary>
+	static void FinishPrewarmTimeZones();
+	/// <summary>
+	/// Use a ZoneDetect database file, memory mapped, instead of the database built into the library. The
+	/// WTIME_ZONEDETECT_DB environment variable does the same thing when this isn't called. If the file can't be opened
+	/// the built in database is used.
+	/// </summary>
+	/// <param name="path">The path to the database, empty to use the built in database.</param>
+	/// <returns>False if the timezone databases have already been opened, in which case nothing changes.</returns>
+	static bool SetTimeZoneDatabase(const std::string& path);
+
     private:
 	static const TimeZoneInfo* TimeZoneFromIndex(const INTNM::int32_t zi, INTNM::int16_t set, bool* valid);
 	
@@ -306,14 +424,8 @@ public:
 		double			m_sun_cache_lat,
 						m_sun_cache_long;
 	};
-	struct sun_val {
-		INTNM::uint64_t	m_sun_cache_rise,
-						m_sun_cache_set,
-						m_sun_cache_noon;
-		INTNM::int16_t	m_success, m_pad;
-	};
+	mutable HSS_Time_Private::SunCache	m_sunCache;
 #ifdef HSS_USE_CACHING
-	mutable ValueCacheTempl_MT<sun_key, sun_val>	m_sunCache;
 	mutable ValueCacheTempl_MT<sun_key, WTimeSpan>m_solarCache;
 #endif
 };
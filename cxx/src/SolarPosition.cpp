@@ -0,0 +1,120 @@
+/**
+ * SolarPosition.cpp
+ *
+ * Copyright 2016-2023 Heartland Software Solutions Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the license at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the LIcense is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SolarPosition.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace HSS_Time_Private;
+
+
+static constexpr double PI = 3.14159265358979323846264;
+static constexpr double TWO_PI = 6.28318530717958647692529;
+static constexpr INTNM::int64_t DAY_MICROSECONDS = 24LL * 60LL * 60LL * 1000000LL;
+
+
+SolarPosition::SolarPosition(double latitude, double longitude)
+	: m_sinLatitude(std::sin(latitude)),
+	  m_cosLatitude(std::cos(latitude)),
+	  m_longitude(longitude),
+	  m_day(-1),
+	  m_declination(0.0),
+	  m_declinationChange(0.0),
+	  m_eqTime(0.0),
+	  m_eqTimeChange(0.0) {
+}
+
+
+void SolarPosition::loadDay(INTNM::int64_t day) {
+	const double jd = CSunriseSunsetCalc::WTIME_EPOCH_JD + (double)day;
+	double eqTime, solarDec, nextEqTime, nextSolarDec;
+	m_calc.calcDayEphemeris(jd, &eqTime, &solarDec);
+	m_calc.calcDayEphemeris(jd + 1.0, &nextEqTime, &nextSolarDec);
+
+	m_declination = m_calc.degToRad(solarDec);
+	m_declinationChange = m_calc.degToRad(nextSolarDec) - m_declination;
+	m_eqTime = eqTime * (PI / 720.0);						// minutes of time to radians of hour angle
+	m_eqTimeChange = nextEqTime * (PI / 720.0) - m_eqTime;
+	m_day = day;
+}
+
+
+void SolarPosition::position(double sinDec, double cosDec, double sinHA, double cosHA, double *elevation, double *azimuth) const {
+	const double cosZenith = m_sinLatitude * sinDec + m_cosLatitude * cosDec * cosHA;
+	*elevation = std::asin(std::fmin(std::fmax(cosZenith, -1.0), 1.0));
+
+	const double a = std::atan2(sinHA * cosDec, cosHA * m_sinLatitude * cosDec - sinDec * m_cosLatitude) + PI;
+	*azimuth = (a >= TWO_PI) ? (a - TWO_PI) : a;
+}
+
+
+void SolarPosition::Position(INTNM::uint64_t time, double *elevation, double *azimuth) {
+	const INTNM::int64_t day = (INTNM::int64_t)(time / DAY_MICROSECONDS);
+	if (day != m_day)
+		loadDay(day);
+
+	const double fraction = (double)((INTNM::int64_t)time - day * DAY_MICROSECONDS) / (double)DAY_MICROSECONDS;
+	const double declination = m_declination + fraction * m_declinationChange;
+	const double hourAngle = fraction * (TWO_PI + m_eqTimeChange) + m_eqTime + m_longitude - PI;
+	position(std::sin(declination), std::cos(declination), std::sin(hourAngle), std::cos(hourAngle), elevation, azimuth);
+}
+
+
+void SolarPosition::Positions(const INTNM::uint64_t *times, std::size_t count, double *elevation, double *azimuth) {
+	for (std::size_t i = 0; i < count; i++)
+		Position(times[i], elevation + i, azimuth + i);
+}
+
+
+void SolarPosition::Positions(INTNM::uint64_t start, INTNM::int64_t step, std::size_t count, double *elevation, double *azimuth) {
+	std::size_t i = 0;
+	while (i < count) {
+		const INTNM::int64_t time = (INTNM::int64_t)start + (INTNM::int64_t)i * step;
+		const INTNM::int64_t day = time / DAY_MICROSECONDS;
+		if (day != m_day)
+			loadDay(day);
+
+		// the declination and hour angle are linear within the day, so each step turns them by the same angle
+		std::size_t steps = count - i;
+		if (step > 0)
+			steps = std::min(steps, (std::size_t)(((day + 1) * DAY_MICROSECONDS - 1 - time) / step + 1));
+		else if (step < 0)
+			steps = std::min(steps, (std::size_t)((time - day * DAY_MICROSECONDS) / -step + 1));
+
+		const double fraction = (double)(time - day * DAY_MICROSECONDS) / (double)DAY_MICROSECONDS;
+		const double stepFraction = (double)step / (double)DAY_MICROSECONDS;
+		const double declination = m_declination + fraction * m_declinationChange;
+		const double hourAngle = fraction * (TWO_PI + m_eqTimeChange) + m_eqTime + m_longitude - PI;
+		double sinDec = std::sin(declination), cosDec = std::cos(declination);
+		double sinHA = std::sin(hourAngle), cosHA = std::cos(hourAngle);
+		const double sinDecStep = std::sin(stepFraction * m_declinationChange), cosDecStep = std::cos(stepFraction * m_declinationChange);
+		const double sinHAStep = std::sin(stepFraction * (TWO_PI + m_eqTimeChange)), cosHAStep = std::cos(stepFraction * (TWO_PI + m_eqTimeChange));
+
+		for (std::size_t j = 0; j < steps; j++, i++) {
+			position(sinDec, cosDec, sinHA, cosHA, elevation + i, azimuth + i);
+
+			const double s = sinDec * cosDecStep + cosDec * sinDecStep;
+			cosDec = cosDec * cosDecStep - sinDec * sinDecStep;
+			sinDec = s;
+			const double h = sinHA * cosHAStep + cosHA * sinHAStep;
+			cosHA = cosHA * cosHAStep - sinHA * sinHAStep;
+			sinHA = h;
+		}
+	}
+}
@@ -0,0 +1,126 @@
+/**
+ * SunCache.cpp
+ *
+ * Copyright 2016-2023 Heartland Software Solutions Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the license at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the LIcense is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SunCache.h"
+
+#include <cmath>
+
+using namespace HSS_Time_Private;
+
+
+SunCache::Key::Key(INTNM::int64_t day, double latitude, double longitude)
+	: m_day(day),
+	  m_latitude(std::llround(std::ldexp(latitude, 32))),
+	  m_longitude(std::llround(std::ldexp(longitude, 32))) {
+}
+
+
+SunCache::SunCache(std::size_t capacity)
+	: m_capacity(capacity),
+	  m_hand(0),
+	  m_last(0),
+	  m_hits(0),
+	  m_misses(0) {
+}
+
+
+SunCache::SunCache(const SunCache &cache)
+	: m_capacity(cache.Capacity()),
+	  m_hand(0),
+	  m_last(0),
+	  m_hits(0),
+	  m_misses(0) {
+}
+
+
+bool SunCache::Retrieve(const Key &key, Value *value) {
+	std::lock_guard<std::mutex> lock(m_lock);
+	if ((m_last < m_entries.size()) && (m_entries[m_last].m_key == key)) {
+		m_entries[m_last].m_referenced = true;
+		*value = m_entries[m_last].m_value;
+		m_hits++;
+		return true;
+	}
+	for (std::size_t i = 0; i < m_entries.size(); i++)
+		if (m_entries[i].m_key == key) {
+			m_entries[i].m_referenced = true;
+			*value = m_entries[i].m_value;
+			m_last = i;
+			m_hits++;
+			return true;
+		}
+	m_misses++;
+	return false;
+}
+
+
+void SunCache::Store(const Key &key, const Value &value) {
+	std::lock_guard<std::mutex> lock(m_lock);
+	if (!m_capacity)
+		return;
+	for (Entry &entry : m_entries)
+		if (entry.m_key == key)						// another thread got here first
+			return;
+
+	if (m_entries.size() < m_capacity) {
+		if (m_entries.capacity() < m_capacity)
+			m_entries.reserve(m_capacity);
+		m_entries.push_back({ key, value, false });
+		m_last = m_entries.size() - 1;
+		return;
+	}
+
+	while (m_entries[m_hand].m_referenced) {		// second chance for anything used since the hand last came by
+		m_entries[m_hand].m_referenced = false;
+		m_hand = (m_hand + 1) % m_entries.size();
+	}
+	m_entries[m_hand] = { key, value, false };
+	m_last = m_hand;
+	m_hand = (m_hand + 1) % m_entries.size();
+}
+
+
+std::size_t SunCache::Capacity() const {
+	std::lock_guard<std::mutex> lock(m_lock);
+	return m_capacity;
+}
+
+
+void SunCache::SetCapacity(std::size_t capacity) {
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_capacity = capacity;
+	std::vector<Entry>().swap(m_entries);
+	m_hand = m_last = 0;
+}
+
+
+void SunCache::Statistics(std::uint64_t *hits, std::uint64_t *misses) const {
+	std::lock_guard<std::mutex> lock(m_lock);
+	if (hits)
+		*hits = m_hits;
+	if (misses)
+		*misses = m_misses;
+}
+
+
+void SunCache::Clear() {
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_entries.clear();
+	m_hand = m_last = 0;
+	m_hits = m_misses = 0;
+}
@@ -38,10 +38,27 @@ void sincos(double val, double* p_sin, double *p_cos)
 
 #include "SunriseSunsetCalc.h"
 
+#include <atomic>
+#include <cstddef>
+
 
 using namespace HSS_Time_Private;
 
 
+// The equation of time and the sun's declination only depend on the time, not on where you are, and every location asks
+// for them at the start of its day.  Those values are kept for the whole process in blocks of days, each filled the first
+// time any day in it is asked for, published with a compare-exchange and never freed.
+struct ephemeris_day {
+	double	m_eqTime;					// minutes
+	double	m_solarDec;					// degrees
+};
+
+static constexpr double EPHEMERIS_FIRST_JD = CSunriseSunsetCalc::WTIME_EPOCH_JD;
+static constexpr std::size_t EPHEMERIS_BLOCK_DAYS = 64;
+static constexpr std::size_t EPHEMERIS_BLOCKS = 8192;			// to 3035
+static std::atomic<const ephemeris_day*> ephemeris_blocks[EPHEMERIS_BLOCKS];
+
+
 CSunriseSunsetCalc::CSunriseSunsetCalc()
 {
 }
@@ -477,6 +494,89 @@ double CSunriseSunsetCalc::calcEquationOfTime(double t)
 	return radToDeg(Etime)*4.0;	// in minutes of time
 }
 
+//***********************************************************************/
+//* Name:    calcSunEphemeris								*/
+//* Type:    Function									*/
+//* Purpose: calculate the equation of time and the declination of the	*/
+//*		sun together, sharing the terms they both need			*/
+//* Arguments:										*/
+//*   t : number of Julian centuries since J2000.0				*/
+//* Return value:										*/
+//*   eqTime : as calcEquationOfTime, in minutes of time			*/
+//*   solarDec : as calcSunDeclination, in degrees				*/
+//***********************************************************************/
+
+void CSunriseSunsetCalc::calcSunEphemeris(double t, double *eqTime, double *solarDec)
+{
+	double epsilon = calcObliquityCorrection(t);
+	double l0 = calcGeomMeanLongSun(t);
+	double e = calcEccentricityEarthOrbit(t);
+	double m = calcGeomMeanAnomalySun(t);
+
+	double mrad = degToRad(m);
+	double sinm = sin(mrad);
+	double sin2m = sin(mrad+mrad);
+	double sin3m = sin(mrad+mrad+mrad);
+	double C = sinm * (1.914602 - t * (0.004817 + 0.000014 * t)) + sin2m * (0.019993 - 0.000101 * t) + sin3m * 0.000289;
+
+	double omega = 125.04 - 1934.136 * t;
+	double lambda = (l0 + C) - 0.00569 - 0.00478 * sin(degToRad(omega));
+	*solarDec = radToDeg(asin(sin(degToRad(epsilon)) * sin(degToRad(lambda))));
+
+	if(epsilon==180)
+	{
+		*eqTime = -9999;
+		return;
+	}
+	double y = tan(degToRad(epsilon)/2.0);
+	y *= y;
+
+	double sin2l0, cos2l0;
+	::sincos(2.0 * degToRad(l0), &sin2l0, &cos2l0);
+	double sin4l0 = sin(4.0 * degToRad(l0));
+
+	double Etime = y * sin2l0 - 2.0 * e * sinm + 4.0 * e * y * sinm * cos2l0
+			- 0.5 * y * y * sin4l0 - 1.25 * e * e * sin2m;
+
+	*eqTime = radToDeg(Etime)*4.0;
+}
+
+//***********************************************************************/
+//* Name:    calcDayEphemeris								*/
+//* Type:    Function									*/
+//* Purpose: the equation of time and the declination of the sun at the	*/
+//*		start of a day, from the table shared by every location		*/
+//* Arguments:										*/
+//*   jd : julian day, as calcJD returns						*/
+//***********************************************************************/
+
+void CSunriseSunsetCalc::calcDayEphemeris(double jd, double *eqTime, double *solarDec)
+{
+	double day = jd - EPHEMERIS_FIRST_JD;
+	if ((day < 0.0) || (day >= (double)(EPHEMERIS_BLOCKS * EPHEMERIS_BLOCK_DAYS)) || (day != floor(day)))
+	{
+		calcSunEphemeris(calcTimeJulianCent(jd), eqTime, solarDec);
+		return;
+	}
+
+	std::size_t index = (std::size_t)day;
+	std::atomic<const ephemeris_day*> &slot = ephemeris_blocks[index / EPHEMERIS_BLOCK_DAYS];
+	const ephemeris_day *block = slot.load(std::memory_order_acquire);
+	if (!block)
+	{
+		ephemeris_day *fill = new ephemeris_day[EPHEMERIS_BLOCK_DAYS];
+		double first = EPHEMERIS_FIRST_JD + (double)(index - index % EPHEMERIS_BLOCK_DAYS);
+		for (std::size_t i = 0; i < EPHEMERIS_BLOCK_DAYS; i++)
+			calcSunEphemeris(calcTimeJulianCent(first + (double)i), &fill[i].m_eqTime, &fill[i].m_solarDec);
+		if (slot.compare_exchange_strong(block, fill, std::memory_order_acq_rel))
+			block = fill;
+		else
+			delete [] fill;		// another thread filled it first
+	}
+	*eqTime = block[index % EPHEMERIS_BLOCK_DAYS].m_eqTime;
+	*solarDec = block[index % EPHEMERIS_BLOCK_DAYS].m_solarDec;
+}
+
 //***********************************************************************/
 //* Name:    calcHourAngleSunrise							*/
 //* Type:    Function									*/
@@ -558,10 +658,10 @@ double CSunriseSunsetCalc::calcSunriseUTC(double JD, double latitude, double lon
 
 	// *** First pass to approximate sunrise
 
-	double eqTime = calcEquationOfTime(t);
+	double eqTime, solarDec;
+	calcDayEphemeris(JD, &eqTime, &solarDec);
 	if(eqTime==-9999)
 		return -9999;
-	double solarDec = calcSunDeclination(t);
 	double hourAngle = calcHourAngleSunrise(latitude, solarDec);
 	if(hourAngle==-9999)
 		return -9999;
@@ -573,10 +673,9 @@ double CSunriseSunsetCalc::calcSunriseUTC(double JD, double latitude, double lon
 	// *** Second pass includes fractional jday in gamma calc
 
 	double newt = calcTimeJulianCent(calcJDFromJulianCent(t) + timeUTC/1440.0); 
-	eqTime = calcEquationOfTime(newt);
+	calcSunEphemeris(newt, &eqTime, &solarDec);
 	if(eqTime==-9999)
 		return -9999;
-	solarDec = calcSunDeclination(newt);
 	hourAngle = calcHourAngleSunrise(latitude, solarDec);
 	if(hourAngle==-9999)
 		return -9999;
@@ -593,15 +692,16 @@ double CSunriseSunsetCalc::calcSunriseUTC(double JD, double latitude, double lon
 //* Purpose: calculate the Universal Coordinated Time (UTC) of solar	*/
 //*		noon for the given day at the given location on earth		*/
 //* Arguments:										*/
-//*   t : number of Julian centuries since J2000.0				*/
+//*   JD  : julian day									*/
 //*   longitude : longitude of observer in degrees				*/
 //* Return value:										*/
 //*   time in minutes from zero Z							*/
 //***********************************************************************/
 
-double CSunriseSunsetCalc::calcSolNoonUTC(double t, double longitude)
+double CSunriseSunsetCalc::calcSolNoonUTC(double JD, double longitude)
 {
-	double eqTime = calcEquationOfTime(t);
+	double eqTime, solarDec;
+	calcDayEphemeris(JD, &eqTime, &solarDec);
 	double solNoonUTC = 720 + (longitude * 4) - eqTime; // min
 	
 	return solNoonUTC;
@@ -626,10 +726,10 @@ double CSunriseSunsetCalc::calcSunsetUTC(double JD, double latitude, double long
 
 	// First calculates sunrise and approx length of day
 
-	double eqTime = calcEquationOfTime(t);
+	double eqTime, solarDec;
+	calcDayEphemeris(JD, &eqTime, &solarDec);
 	if(eqTime==-9999)
 		return -9999;
-	double solarDec = calcSunDeclination(t);
 	double hourAngle = calcHourAngleSunset(latitude, solarDec);
 
 	if(hourAngle==-9999)
@@ -641,10 +741,9 @@ double CSunriseSunsetCalc::calcSunsetUTC(double JD, double latitude, double long
 	// first pass used to include fractional day in gamma calc
 
 	double newt = calcTimeJulianCent(calcJDFromJulianCent(t) + timeUTC/1440.0); 
-	eqTime = calcEquationOfTime(newt);
+	calcSunEphemeris(newt, &eqTime, &solarDec);
 	if(eqTime==-9999)
 		return -9999;
-	solarDec = calcSunDeclination(newt);
 	hourAngle = calcHourAngleSunset(latitude, solarDec);
 	if(hourAngle==-9999)
 		return -9999;
@@ -657,6 +756,99 @@ double CSunriseSunsetCalc::calcSunsetUTC(double JD, double latitude, double long
 }
 
 
+//***********************************************************************/
+//* Name:    calcPolarDay								*/
+//* Type:    Function									*/
+//* Purpose: whether the sun stays up, or stays down, all of the given	*/
+//*		day, from its declination at the start of the day as the	*/
+//*		first pass of calcSunriseUTC/calcSunsetUTC has it		*/
+//* Arguments:										*/
+//*   jd  : julian day									*/
+//*   latitude : latitude of observer in degrees				*/
+//* Return value:										*/
+//*   1 if the sun stays up, -1 if it stays down, 0 otherwise		*/
+//***********************************************************************/
+
+INTNM::int32_t CSunriseSunsetCalc::calcPolarDay(double jd, double latitude)
+{
+	double eqTime, solarDec;
+	calcDayEphemeris(jd, &eqTime, &solarDec);
+	if (calcHourAngleSunset(latitude, solarDec) != -9999)
+		return 0;
+	// halfway between the declinations that end the polar day and the polar night
+	if (latitude >= 0.0)
+		return (solarDec > -0.833) ? 1 : -1;
+	return (solarDec < 0.833) ? 1 : -1;
+}
+
+//***********************************************************************/
+//* Name:    findPolarBoundary							*/
+//* Type:    Function									*/
+//* Purpose: the first day, going backwards or forwards from the given	*/
+//*		day, that calcPolarDay doesn't put in the same polar day or	*/
+//*		night as the given day							*/
+//* Arguments:										*/
+//*   jd  : julian day									*/
+//*   latitude : latitude of observer in degrees				*/
+//*   direction : -1.0 to go backwards, 1.0 to go forwards			*/
+//* Return value:										*/
+//*   jd if it isn't in a polar day or night					*/
+//* Note:											*/
+//*   The declination that ends a polar day (the sun's lowest point	*/
+//*   reaches -0.833 degrees) or night (its highest point does) only	*/
+//*   depends on the latitude.  Where a cosine through the solstices	*/
+//*   reaches it is within a day or two, and the days are then checked	*/
+//*   one at a time from there, so the cost doesn't grow with the		*/
+//*   length of the polar day or night.						*/
+//***********************************************************************/
+
+double CSunriseSunsetCalc::findPolarBoundary(double jd, double latitude, double direction)
+{
+	INTNM::int32_t polar = calcPolarDay(jd, latitude);
+	if (!polar)
+		return jd;
+
+	double boundary;
+	if (latitude >= 0.0)
+		boundary = (polar > 0) ? (180.0 - 90.833 - latitude) : (latitude - 90.833);
+	else
+		boundary = (polar > 0) ? (-180.0 + 90.833 - latitude) : (latitude + 90.833);
+
+	// the declination as -23.44 * cos(phase), the phase starting at the December solstice of 1999, so it rises through the
+	// boundary at the first root and falls through it at the second
+	const double year = 365.2422;
+	const double twoPi = 6.28318530717958647692529;
+	double days = 0.0;
+	double ratio = -boundary / 23.44;
+	if (fabs(ratio) < 1.0)
+	{
+		bool above = (latitude >= 0.0) == (polar > 0);		// whether the declination is above the boundary for now
+		double rising = acos(ratio);
+		double root = ((direction > 0.0) == above) ? (twoPi - rising) : rising;
+		double phase = fmod(twoPi * (jd - 2451534.82) / year, twoPi);
+		double angle = fmod((direction > 0.0) ? (root - phase) : (phase - root), twoPi);
+		if (angle < 0.0)
+			angle += twoPi;
+		if (angle > twoPi - twoPi * 10.0 / year)		// the cosine has it just behind us, so it's really just ahead
+			angle = 0.0;
+		days = floor(angle * year / twoPi + 0.5);
+	}
+
+	// polar days and nights are contiguous, so check outwards or inwards from the estimate for the first day past this one
+	if (calcPolarDay(jd + direction * days, latitude) == polar)
+	{
+		do
+			days += 1.0;
+		while (calcPolarDay(jd + direction * days, latitude) == polar);
+	}
+	else
+	{
+		while ((days > 1.0) && (calcPolarDay(jd + direction * (days - 1.0), latitude) != polar))
+			days -= 1.0;
+	}
+	return jd + direction * days;
+}
+
 //***********************************************************************/
 //* Name:    findRecentSunrise							*/
 //* Type:    Function									*/
@@ -677,7 +869,8 @@ double CSunriseSunsetCalc::findRecentSunrise(double jd, double latitude, double
 	double time = calcSunriseUTC(julianday, latitude, longitude);
 	while(time==-9999)//!isNumber(time))
 	{
-		julianday -= 1.0;
+		double boundary = findPolarBoundary(julianday, latitude, -1.0);
+		julianday = (boundary != julianday) ? boundary : (julianday - 1.0);
 		time = calcSunriseUTC(julianday, latitude, longitude);
 	}
 
@@ -704,7 +897,8 @@ double CSunriseSunsetCalc::findRecentSunset(double jd, double latitude, double l
 	double time = calcSunsetUTC(julianday, latitude, longitude);
 	while(time==-9999)//!isNumber(time))
 	{
-		julianday -= 1.0;
+		double boundary = findPolarBoundary(julianday, latitude, -1.0);
+		julianday = (boundary != julianday) ? boundary : (julianday - 1.0);
 		time = calcSunsetUTC(julianday, latitude, longitude);
 	}
 
@@ -731,7 +925,8 @@ double CSunriseSunsetCalc::findNextSunrise(double jd, double latitude, double lo
 	double time = calcSunriseUTC(julianday, latitude, longitude);
 	while(time==-9999)//!isNumber(time))
 	{
-		julianday += 1.0;
+		double boundary = findPolarBoundary(julianday, latitude, 1.0);
+		julianday = (boundary != julianday) ? boundary : (julianday + 1.0);
 		time = calcSunriseUTC(julianday, latitude, longitude);
 	}
 
@@ -758,7 +953,8 @@ double CSunriseSunsetCalc::findNextSunset(double jd, double latitude, double lon
 	double time = calcSunsetUTC(julianday, latitude, longitude);
 	while(time==-9999)//!isNumber(time))
 	{
-		julianday += 1.0;
+		double boundary = findPolarBoundary(julianday, latitude, 1.0);
+		julianday = (boundary != julianday) ? boundary : (julianday + 1.0);
 		time = calcSunsetUTC(julianday, latitude, longitude);
 	}
 
@@ -1030,10 +1226,8 @@ INTNM::int16_t CSunriseSunsetCalc::calcSun(RISESET_IN_STRUCT &latLongForm, RISES
 
 		double JD = calcJD(latLongForm.year, latLongForm.month, latLongForm.day);
 		double doy = calcDayOfYear(latLongForm.month, latLongForm.day, isLeapYear(latLongForm.year));
-		double T = calcTimeJulianCent(JD);
-		calcSunRtAscension(T);
-		double theta = calcSunDeclination(T);
-		double Etime = calcEquationOfTime(T);
+		double theta, Etime;
+		calcDayEphemeris(JD, &Etime, &theta);
 
 //*********************************************************************/
 
@@ -1101,7 +1295,7 @@ INTNM::int16_t CSunriseSunsetCalc::calcSun(RISESET_IN_STRUCT &latLongForm, RISES
 
 		// Calculate solar noon for this date
 
-		double solNoonGMT = calcSolNoonUTC(T, longitude);
+		double solNoonGMT = calcSolNoonUTC(JD, longitude);
 		double solNoonLST = solNoonGMT - (60 * zone) + daySavings;
 
 		timeString(solNoonLST,&hourOut,&minOut,&secOut);
@@ -1246,3 +1440,67 @@ INTNM::int16_t CSunriseSunsetCalc::calcSun(RISESET_IN_STRUCT &latLongForm, RISES
 	}
 	return retval;
 }
+
+
+//***********************************************************************/
+//* Name:    calcSunBatch								*/
+//* Type:    Function									*/
+//* Purpose: sunrise, sunset and solar noon for many locations on one	*/
+//*		day, in the same two passes as calcSunriseUTC/calcSunsetUTC	*/
+//* Arguments:										*/
+//*   year, month, day : the date, as for calcSun				*/
+//*   latitude, longitude : count positions in degrees, west positive	*/
+//* Return value:										*/
+//*   riseUTC, setUTC, noonUTC : count times in minutes from zero Z of	*/
+//*		the date, rise and set are undefined where flagged		*/
+//*   flags : count of NO_SUNRISE | NO_SUNSET						*/
+//* Note:											*/
+//*   Unlike calcSun, a location in polar day or night is only flagged,	*/
+//*   no other day is searched for its rise or set.  The loop has no	*/
+//*   branches on the flags so it can be vectorized.				*/
+//***********************************************************************/
+
+void CSunriseSunsetCalc::calcSunBatch(INTNM::int32_t year, INTNM::int32_t month, INTNM::int32_t day, const double *latitude, const double *longitude, std::size_t count,
+	double *riseUTC, double *setUTC, double *noonUTC, INTNM::int16_t *flags)
+{
+	double JD = calcJD(year, month, day);
+	double jd = calcJDFromJulianCent(calcTimeJulianCent(JD));
+	double eqTime, solarDec;
+	calcDayEphemeris(JD, &eqTime, &solarDec);
+
+	const double cosZenith = cos(degToRad(90.833));
+	const double cosDec = cos(degToRad(solarDec));
+	const double tanDec = tan(degToRad(solarDec));
+
+	for (std::size_t i = 0; i < count; i++)
+	{
+		double lat = fmin(fmax(latitude[i], -89.8), 89.8);
+		double lon = longitude[i];
+		double latRad = degToRad(lat);
+		double cosLat = cos(latRad);
+		double tanLat = tan(latRad);
+
+		// first pass, the sun's position at the start of the day is the same for rise and set
+		double HAarg = cosZenith/(cosLat*cosDec)-tanLat * tanDec;
+		bool polar = fabs(HAarg) > 1;
+		double HA = radToDeg(acos(fmin(fmax(HAarg, -1.0), 1.0)));
+		double riseFirst = 720 + 4 * (lon - HA) - eqTime;
+		double setFirst = 720 + 4 * (lon + HA) - eqTime;
+
+		// second pass, at the approximate time of each
+		double riseEqTime, riseDec, setEqTime, setDec;
+		calcSunEphemeris(calcTimeJulianCent(jd + riseFirst/1440.0), &riseEqTime, &riseDec);
+		calcSunEphemeris(calcTimeJulianCent(jd + setFirst/1440.0), &setEqTime, &setDec);
+		double riseDecRad = degToRad(riseDec);
+		double setDecRad = degToRad(setDec);
+		double riseArg = cosZenith/(cosLat*cos(riseDecRad))-tanLat * tan(riseDecRad);
+		double setArg = cosZenith/(cosLat*cos(setDecRad))-tanLat * tan(setDecRad);
+		double riseHA = radToDeg(acos(fmin(fmax(riseArg, -1.0), 1.0)));
+		double setHA = radToDeg(acos(fmin(fmax(setArg, -1.0), 1.0)));
+
+		riseUTC[i] = 720 + 4 * (lon - riseHA) - riseEqTime;
+		setUTC[i] = 720 + 4 * (lon + setHA) - setEqTime;
+		noonUTC[i] = 720 + (lon * 4) - eqTime;
+		flags[i] = (INTNM::int16_t)(((polar | (fabs(riseArg) > 1)) * NO_SUNRISE) | ((polar | (fabs(setArg) > 1)) * NO_SUNSET));
+	}
+}
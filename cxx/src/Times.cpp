@@ -39,6 +39,7 @@
 #include <codecvt>
 #include <assert.h>
 #include <optional>
+#include <charconv>
 #include <inttypes.h>
 #include <sys/stat.h>
 
@@ -639,7 +640,90 @@ COleDateTimeSpan WTimeSpan::AsCOleDateTimeSpan() const {
 #endif
 
 
-WTimeManager::WTimeManager(const WorldLocation &worldLocation) : m_worldLocation(worldLocation) {
+WTimeManager::WTimeManager(const WorldLocation &worldLocation)
+	: m_worldLocation(worldLocation),
+	  m_dstSequence(0),
+	  m_dstKey(0),
+	  m_dstYearStart(0),
+	  m_dstYearEnd(0),
+	  m_dstStart(0),
+	  m_dstEnd(0) {
+}
+
+
+WTimeManager::WTimeManager(const WTimeManager &tm)
+	: m_worldLocation(tm.m_worldLocation),
+	  m_dstSequence(0),
+	  m_dstKey(0),
+	  m_dstYearStart(0),
+	  m_dstYearEnd(0),
+	  m_dstStart(0),
+	  m_dstEnd(0) {
+}
+
+
+static constexpr INTNM::int64_t DAY_MICROSECONDS = 24LL * 60LL * 60LL * 1000000LL;
+
+
+// the test adjusted_tm_math has always made, on the seconds into the year of a time that's already been moved to local time
+static bool dst_window(const WorldLocation &wl, INTNM::uint64_t time) {
+	const INTNM::int32_t year = CivilCalendar::CivilFromDays((INTNM::int64_t)(time / DAY_MICROSECONDS)).m_year;
+	const INTNM::uint64_t secs = (time - (INTNM::uint64_t)CivilCalendar::YearStart(year) * (INTNM::uint64_t)DAY_MICROSECONDS) / 1000000LL;
+	if (wl.m_startDST() < wl.m_endDST())
+		return ((INTNM::uint64_t)wl.m_startDST().GetTotalSeconds() <= secs) && (secs < (INTNM::uint64_t)wl.m_endDST().GetTotalSeconds());
+	return ((INTNM::uint64_t)wl.m_startDST().GetTotalSeconds() < secs) || (secs <= (INTNM::uint64_t)wl.m_endDST().GetTotalSeconds());
+}
+
+
+bool WTimeManager::isDST(INTNM::uint64_t time) const {
+	const WorldLocation &wl = m_worldLocation;
+	const INTNM::uint64_t key = ((INTNM::uint64_t)wl._generation + 1) << 1;
+
+	INTNM::uint32_t sequence = m_dstSequence.load(std::memory_order_acquire);
+	if (!(sequence & 1)) {
+		const INTNM::uint64_t entry = m_dstKey.load(std::memory_order_relaxed);
+		const INTNM::uint64_t year_start = m_dstYearStart.load(std::memory_order_relaxed);
+		const INTNM::uint64_t year_end = m_dstYearEnd.load(std::memory_order_relaxed);
+		const INTNM::uint64_t start = m_dstStart.load(std::memory_order_relaxed);
+		const INTNM::uint64_t end = m_dstEnd.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if ((m_dstSequence.load(std::memory_order_relaxed) == sequence) && ((entry & ~1ULL) == key) && (year_start <= time) && (time < year_end)) {
+			if (entry & 1)
+				return (start <= time) || (time < end);
+			return (start <= time) && (time < end);
+		}
+	}
+
+	const INTNM::int64_t offset = wl.m_timezone().GetTotalMicroSeconds();
+	const INTNM::int64_t start_secs = wl.m_startDST().GetTotalSeconds(), end_secs = wl.m_endDST().GetTotalSeconds();
+	const INTNM::uint64_t local = time + offset;
+	// times out near the end of the range (an unset time is (uint64_t)-1) don't fit the signed arithmetic below
+	if ((start_secs < 0) || (end_secs < 0) || (local > (INTNM::uint64_t)(INT64_MAX - 2 * 366 * DAY_MICROSECONDS)))
+		return dst_window(wl, local);				// the unsigned comparisons in dst_window don't map onto instants
+	const INTNM::int32_t year = CivilCalendar::CivilFromDays((INTNM::int64_t)(local / DAY_MICROSECONDS)).m_year;
+	const INTNM::int64_t year_start = CivilCalendar::YearStart(year) * DAY_MICROSECONDS - offset;
+	if (year_start < 0)
+		return dst_window(wl, local);
+
+	// a window that wraps past the end of the year starts after its start second and ends after its end second, see dst_window
+	const bool inverted = !(wl.m_startDST() < wl.m_endDST());
+	const INTNM::uint64_t year_end = (INTNM::uint64_t)(CivilCalendar::YearStart(year + 1) * DAY_MICROSECONDS - offset);
+	const INTNM::uint64_t start = (INTNM::uint64_t)year_start + (INTNM::uint64_t)(start_secs + (inverted ? 1 : 0)) * 1000000ULL;
+	const INTNM::uint64_t end = (INTNM::uint64_t)year_start + (INTNM::uint64_t)(end_secs + (inverted ? 1 : 0)) * 1000000ULL;
+
+	if ((!(sequence & 1)) && (m_dstSequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_acq_rel))) {
+		std::atomic_thread_fence(std::memory_order_release);		// keeps the stores below from being seen before the odd sequence
+		m_dstKey.store(key | (inverted ? 1 : 0), std::memory_order_relaxed);
+		m_dstYearStart.store((INTNM::uint64_t)year_start, std::memory_order_relaxed);
+		m_dstYearEnd.store(year_end, std::memory_order_relaxed);
+		m_dstStart.store(start, std::memory_order_relaxed);
+		m_dstEnd.store(end, std::memory_order_relaxed);
+		m_dstSequence.store(sequence + 2, std::memory_order_release);
+	}
+
+	if (inverted)
+		return (start <= time) || (time < end);
+	return (start <= time) && (time < end);
 }
 
 
@@ -1072,15 +1156,7 @@ WTime::WTime(INTNM::int32_t nYear, INTNM::int32_t nMonth, INTNM::int32_t nDay, I
 
 void WTime::construct_time_t(INTNM::int32_t nYear, INTNM::int32_t nMonth, INTNM::int32_t nDay, INTNM::int32_t nHour, INTNM::int32_t nMin, INTNM::int32_t nSec)
 {
-	if (nMonth <= 2) 
-	{
-		nYear -= 1;
-		nMonth += 12;
-	}
-	INTNM::int32_t A = nYear/100LL;
-	INTNM::int32_t B = 2LL - A + A/4;
-	m_time = floor(365.25*(nYear + 4716)) + floor(30.6001*(nMonth+1)) + (nDay+1) + B - 1524.5;
-	m_time -= 2305448; //normalize to epoch
+	m_time = (INTNM::uint64_t)CivilCalendar::DaysFromCivil(nYear, nMonth, nDay);
 	m_time *= 24;
 	m_time += nHour;
 	m_time *= 60;
@@ -1127,6 +1203,16 @@ INTNM::uint64_t WTime::adjusted_tm_math(INTNM::uint32_t mode) const {
 			throw std::runtime_error("Operation not supported");
 	INTNM::uint64_t time;
 	if (m_tm) {
+		if ((mode & (WTIME_FORMAT_AS_LOCAL | WTIME_FORMAT_WITHHISTORY)) == (WTIME_FORMAT_AS_LOCAL | WTIME_FORMAT_WITHHISTORY)) {
+			const TimeZoneInfo* tzi = m_tm->m_worldLocation._timezoneInfo;
+			if ((tzi) && (tzi->m_transitions)) {
+				const TimeZoneOffset& offset = tzi->m_transitions->find(m_time);
+				if (mode & WTIME_FORMAT_WITHDST)
+					return m_time + (INTNM::int64_t)offset.m_offset * 1000000LL;
+				return m_time + (INTNM::int64_t)(offset.m_offset - offset.m_save) * 1000000LL;
+			}
+		}
+
 		if (mode & WTIME_FORMAT_AS_LOCAL)
 			time = m_time + m_tm->m_worldLocation.m_timezone().GetTotalMicroSeconds();
 		else if (mode & WTIME_FORMAT_AS_SOLAR)
@@ -1134,17 +1220,8 @@ INTNM::uint64_t WTime::adjusted_tm_math(INTNM::uint32_t mode) const {
 		else	time = m_time;
 
 		if ((mode & WTIME_FORMAT_WITHDST) && (m_tm->m_worldLocation.m_startDST() != m_tm->m_worldLocation.m_endDST())) {
-			WTime t(time, nullptr, false);
-			INTNM::uint64_t secs = t.GetSecondsIntoYear(0);
-			if (m_tm->m_worldLocation.m_startDST() < m_tm->m_worldLocation.m_endDST()) {
-				if (((INTNM::uint64_t)m_tm->m_worldLocation.m_startDST().GetTotalSeconds() <= secs) &&
-				    (secs < (INTNM::uint64_t)m_tm->m_worldLocation.m_endDST().GetTotalSeconds()))
-					time += m_tm->m_worldLocation.m_amtDST().GetTotalMicroSeconds();
-			} else {
-				if (((INTNM::uint64_t)m_tm->m_worldLocation.m_startDST().GetTotalSeconds() < secs) ||
-				    (secs <= (INTNM::uint64_t)m_tm->m_worldLocation.m_endDST().GetTotalSeconds()))
-					time += m_tm->m_worldLocation.m_amtDST().GetTotalMicroSeconds();
-			}
+			if ((mode & WTIME_FORMAT_AS_LOCAL) ? m_tm->isDST(m_time) : dst_window(m_tm->m_worldLocation, time))
+				time += m_tm->m_worldLocation.m_amtDST().GetTotalMicroSeconds();
 		}
 	} else	time = m_time;
 	return time;
@@ -1174,21 +1251,109 @@ GDALTime WTime::AsGDALTime(INTNM::uint32_t mode) const {
 }
 
 
+WTimeFields WTime::Decompose(INTNM::uint32_t flags) const {
+	WTimeFields fields;
+	if (m_time == (INTNM::uint64_t)(-1)) {
+		fields.m_year = fields.m_month = fields.m_day = fields.m_hour = fields.m_minute = fields.m_second = fields.m_microSeconds = -1;
+		fields.m_dayOfWeek = fields.m_dayOfYear = -1;
+		return fields;
+	}
+
+	INTNM::uint64_t atm = adjusted_tm(flags);
+	INTNM::uint64_t days = atm / (24LL * 60LL * 60LL * 1000000LL);
+	INTNM::uint64_t usecs = atm % (24LL * 60LL * 60LL * 1000000LL);
+	CivilCalendar::CivilDate date = CivilCalendar::CivilFromDays((INTNM::int64_t)days);
+	fields.m_year = date.m_year;
+	fields.m_month = date.m_month;
+	fields.m_day = date.m_day;
+	fields.m_hour = (INTNM::int32_t)(usecs / (60LL * 60LL * 1000000LL));
+	fields.m_minute = (INTNM::int32_t)((usecs / (60LL * 1000000LL)) % 60);
+	fields.m_second = (INTNM::int32_t)((usecs / 1000000LL) % 60);
+	fields.m_microSeconds = (INTNM::int32_t)(usecs % 1000000LL);
+	fields.m_dayOfWeek = CivilCalendar::DayOfWeek((INTNM::int64_t)days);
+	fields.m_dayOfYear = (INTNM::int32_t)((INTNM::int64_t)days - CivilCalendar::YearStart(date.m_year)) + 1;
+	return fields;
+}
+
+
+// Built twice on x86 compilers that can dispatch on the CPU at load time, once for AVX2 and once for the baseline. The dispatch
+// needs an ifunc from the loader, which only ELF targets have, so MinGW, Cygwin and Apple builds get the baseline alone.
+#if defined(__GNUC__) && defined(__ELF__) && (defined(__x86_64__) || defined(__i386__)) && !defined(__INTEL_COMPILER)
+#define WTIME_AVX2_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define WTIME_AVX2_CLONES
+#endif
+
+
+// CivilCalendar::CivilFromDays and friends, rewritten for a block of unsigned 32 bit day counts and seconds into the day so the
+// loop vectorizes. Counting from March 1, 1200 (one era before 1600) keeps every intermediate positive.
+WTIME_AVX2_CLONES
+static void civil_columns(const INTNM::uint32_t *days, const INTNM::uint32_t *seconds, std::size_t count, const WTimeColumns &columns, std::size_t offset) {
+	INTNM::int32_t *year = columns.m_year + offset, *month = columns.m_month + offset, *day = columns.m_day + offset,
+		*hour = columns.m_hour + offset, *minute = columns.m_minute + offset, *second = columns.m_second + offset,
+		*day_of_year = columns.m_dayOfYear + offset;
+	constexpr INTNM::uint32_t DAYS_PER_ERA = (INTNM::uint32_t)CivilCalendar::DAYS_PER_ERA;
+	constexpr INTNM::uint32_t MARCH_1_1200 = DAYS_PER_ERA - (INTNM::uint32_t)CivilCalendar::MARCH_1_1600;
+
+	#pragma omp simd
+	for (std::size_t i = 0; i < count; i++) {
+		const INTNM::uint32_t z = days[i] + MARCH_1_1200;
+		const INTNM::uint32_t era = z / DAYS_PER_ERA;
+		const INTNM::uint32_t day_of_era = z - era * DAYS_PER_ERA;
+		const INTNM::uint32_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / (DAYS_PER_ERA - 1)) / 365;
+		const INTNM::uint32_t day_of_march_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+		const INTNM::uint32_t month_from_march = (5 * day_of_march_year + 2) / 153;
+		const INTNM::uint32_t january = month_from_march >= 10 ? 1 : 0;
+		// March through December are in year_of_era, which is the year's remainder after dividing by 400
+		const INTNM::uint32_t leap = (((year_of_era & 3) == 0) && (((year_of_era % 100) != 0) || (year_of_era == 0))) ? 1 : 0;
+
+		year[i] = (INTNM::int32_t)(era * 400 + year_of_era + january) + 1200;
+		month[i] = (INTNM::int32_t)(january ? month_from_march - 9 : month_from_march + 3);
+		day[i] = (INTNM::int32_t)(day_of_march_year - (153 * month_from_march + 2) / 5 + 1);
+		day_of_year[i] = (INTNM::int32_t)(january ? day_of_march_year - 305 : day_of_march_year + 60 + leap);
+		hour[i] = (INTNM::int32_t)(seconds[i] / 3600);
+		minute[i] = (INTNM::int32_t)((seconds[i] / 60) % 60);
+		second[i] = (INTNM::int32_t)(seconds[i] % 60);
+	}
+}
+
+
+void WTime::Decompose(const INTNM::uint64_t *times, std::size_t count, const WTimeManager *tm, INTNM::uint32_t flags, const WTimeColumns &columns) {
+	constexpr std::size_t BLOCK = 1024;
+	INTNM::uint32_t days[BLOCK], seconds[BLOCK];
+
+	for (std::size_t offset = 0; offset < count; offset += BLOCK) {
+		const std::size_t block = std::min(BLOCK, count - offset);
+		bool unset = false;
+		for (std::size_t i = 0; i < block; i++) {
+			const INTNM::uint64_t time = times[offset + i];
+			INTNM::uint64_t atm;
+			if (time == (INTNM::uint64_t)(-1)) {
+				atm = 0;
+				unset = true;
+			}
+			else
+				atm = WTime(time, tm, false).adjusted_tm(flags) / 1000000LL;
+			days[i] = (INTNM::uint32_t)(atm / (24LL * 60LL * 60LL));
+			seconds[i] = (INTNM::uint32_t)(atm % (24LL * 60LL * 60LL));
+		}
+
+		civil_columns(days, seconds, block, columns, offset);
+
+		if (unset)
+			for (std::size_t i = offset; i < offset + block; i++)
+				if (times[i] == (INTNM::uint64_t)(-1))
+					columns.m_year[i] = columns.m_month[i] = columns.m_day[i] = columns.m_hour[i] = columns.m_minute[i] =
+						columns.m_second[i] = columns.m_dayOfYear[i] = -1;
+	}
+}
+
+
 INTNM::int32_t WTime::GetYear(INTNM::uint32_t mode) const {
 	if (m_time == (INTNM::uint64_t)(-1))
 		return -1;
 
-	INTNM::uint64_t z = adjusted_tm(mode) / 24 / 60 / 60 / 1000000;
-	z += 2305448;
-
-	INTNM::int64_t a = z + 32044;
-	INTNM::int64_t b = (4*a+3)/146097;
-	INTNM::int64_t c = a - (b*146097)/4;
-	INTNM::int64_t d = (4*c+3)/1461;
-	INTNM::int64_t e = c - (1461*d)/4;
-	INTNM::int64_t m = (5*e+2)/153;
-	INTNM::int64_t nyear = b*100 + d - 4800 + m/10;
-	return (INTNM::int32_t)nyear;
+	return CivilCalendar::CivilFromDays((INTNM::int64_t)(adjusted_tm(mode) / (24LL * 60LL * 60LL * 1000000LL))).m_year;
 }
 
 
@@ -1196,16 +1361,7 @@ INTNM::int32_t WTime::GetMonth(INTNM::uint32_t mode) const {
 	if (m_time == (INTNM::uint64_t)(-1))
 		return -1;
 
-	INTNM::uint64_t z = adjusted_tm(mode) / 24 / 60 / 60 / 1000000;
-	z += 2305448;
-	INTNM::int64_t a = z + 32044;
-	INTNM::int64_t b = (4*a+3)/146097;
-	INTNM::int64_t c = a - (b*146097)/4;
-	INTNM::int64_t d = (4*c+3)/1461;
-	INTNM::int64_t e = c - (1461*d)/4;
-	INTNM::int64_t m = (5*e+2)/153;
-	INTNM::int64_t nmonth = m + 3 - 12*(m/10);
-	return (INTNM::int32_t)nmonth;
+	return CivilCalendar::CivilFromDays((INTNM::int64_t)(adjusted_tm(mode) / (24LL * 60LL * 60LL * 1000000LL))).m_month;
 }
 
 
@@ -1213,17 +1369,7 @@ INTNM::int32_t WTime::GetDay(INTNM::uint32_t mode) const {
 	if (m_time == (INTNM::uint64_t)(-1))
 		return -1;
 
-	INTNM::uint64_t z = adjusted_tm(mode) / 24 / 60 / 60 / 1000000;
-	z += 2305448;
-
-	INTNM::int64_t a = z + 32044;
-	INTNM::int64_t b = (4*a+3)/146097;
-	INTNM::int64_t c = a - (b*146097)/4;
-	INTNM::int64_t d = (4*c+3)/1461;
-	INTNM::int64_t e = c - (1461*d)/4;
-	INTNM::int64_t m = (5*e+2)/153;
-	INTNM::int64_t nday = e - (153*m+2)/5 + 1;
-	return (INTNM::int32_t)nday;
+	return CivilCalendar::CivilFromDays((INTNM::int64_t)(adjusted_tm(mode) / (24LL * 60LL * 60LL * 1000000LL))).m_day;
 }
 
 
@@ -1245,9 +1391,8 @@ INTNM::uint64_t WTime::GetSecondsIntoYear(INTNM::uint32_t mode) const {
 	if (m_time == (INTNM::uint64_t)(-1))
 		return (INTNM::uint64_t)-1;
 
-	INTNM::uint64_t atm = adjusted_tm(mode) / 1000000;
-	WTime year(GetYear(mode), 1, 1, 0, 0, 0, m_tm);
-	return (atm - year.GetTotalSeconds());
+	WTimeFields fields = Decompose(mode);
+	return ((fields.m_dayOfYear - 1) * 24LL + fields.m_hour) * 60LL * 60LL + fields.m_minute * 60LL + fields.m_second;
 }
 
 
@@ -1255,9 +1400,9 @@ WTimeSpan WTime::GetWTimeSpanIntoYear(INTNM::uint32_t mode) const {
 	if (m_time == (INTNM::uint64_t)(-1))
 		return WTimeSpan(-1, false);
 
-	INTNM::uint64_t atm = adjusted_tm(mode);
-	WTime year(GetYear(mode), 1, 1, 0, 0, 0, m_tm);
-	return WTimeSpan((INTNM::int64_t)(atm - year.m_time), false);
+	WTimeFields fields = Decompose(mode);
+	INTNM::int64_t secs = ((fields.m_dayOfYear - 1) * 24LL + fields.m_hour) * 60LL * 60LL + fields.m_minute * 60LL + fields.m_second;
+	return WTimeSpan(secs * 1000000LL + fields.m_microSeconds, false);
 }
 
 
@@ -1273,10 +1418,7 @@ INTNM::int32_t WTime::GetDayOfYear(INTNM::uint32_t mode) const {
 	if (m_time == (INTNM::uint64_t)(-1))
 		return -1;
 
-	INTNM::uint64_t atm = adjusted_tm(mode) / 24 / 60 / 60 / 1000000;
-	WTime year(GetYear(mode), 1, 1, 0, 0, 0.0, m_tm);
-	INTNM::uint64_t year_atm = year.adjusted_tm(0) / 24 / 60 / 60 / 1000000;
-	return (INTNM::uint32_t)(atm - year_atm) + 1;
+	return Decompose(mode).m_dayOfYear;
 }
 
 
@@ -1284,9 +1426,8 @@ double WTime::GetDayFractionOfYear(INTNM::uint32_t mode) const {
 	if (m_time == (INTNM::uint64_t)(-1))
 		return -1.0;
 
-	INTNM::uint64_t atm = adjusted_tm(mode) / 1000000;
-	WTime year(GetYear(mode), 1, 1, 0, 0, 0.0, m_tm);
-	INTNM::uint64_t total_secs = atm - year.GetTotalSeconds();
+	WTimeFields fields = Decompose(mode);
+	INTNM::uint64_t total_secs = ((fields.m_dayOfYear - 1) * 24LL + fields.m_hour) * 60LL * 60LL + fields.m_minute * 60LL + fields.m_second;
 	return ((long double)total_secs) / (24.0 * 60.0 * 60.0) + 1.0;
 }
 
@@ -1440,15 +1581,15 @@ std::string WTime::ToString(INTNM::uint32_t flags) const {
 		return str;
 	}
 
-	year = GetYear(flags);
-	month = GetMonth(flags);
-	day = GetDay(flags);
-	hour = GetHour(flags);
-	minute = GetMinute(flags);
-	second = GetSecond(flags);
-	usecs = GetMicroSeconds(flags);
-
-	day_of_week = GetDayOfWeek(flags);
+	WTimeFields fields = Decompose(flags);
+	year = fields.m_year;
+	month = fields.m_month;
+	day = fields.m_day;
+	hour = fields.m_hour;
+	minute = fields.m_minute;
+	second = fields.m_second;
+	usecs = fields.m_microSeconds;
+	day_of_week = fields.m_dayOfWeek;
 
 	if (flags & WTIME_FORMAT_ABBREV) {		// decide if we should be abbreviating things or not
 		month_str = WTimeManager::months_abbrev[month - 1];
@@ -1612,7 +1753,75 @@ bool WTime::ParseDateTime(const std::wstring &lpszDate, INTNM::uint32_t flags)
 }
 
 
-bool WTime::ParseDateTime(const std::string &lpszDate, INTNM::uint32_t flags, WorldLocation* location) {
+// exactly count digits at str[at], no signs or spaces
+static inline bool iso_digits(std::string_view str, std::size_t at, std::size_t count, INTNM::int32_t &value) {
+	if (str.size() < at + count)
+		return false;
+	INTNM::uint32_t v;
+	const char *first = str.data() + at, *last = first + count;
+	std::from_chars_result result = std::from_chars(first, last, v);
+	if ((result.ec != std::errc()) || (result.ptr != last))
+		return false;
+	value = (INTNM::int32_t)v;
+	return true;
+}
+
+
+// the ISO 8601 layouts that ToString(WTIME_FORMAT_STRING_ISO8601) writes: YYYY-MM-DD, optionally followed by T (or a space) and
+// hh:mm or hh:mm:ss, then optionally by Z or +hh:mm/-hh:mm.  Only strings that the general parser would read the same way are
+// accepted, anything else (fractional seconds, out of range fields, extra text) returns false and is left to it.
+static bool parse_iso8601(std::string_view date, INTNM::uint32_t flags, INTNM::int32_t &year, INTNM::int32_t &month, INTNM::int32_t &day,
+	INTNM::int32_t &hour, INTNM::int32_t &min, INTNM::int32_t &sec, INTNM::int64_t &secondOffset, bool &offsetExists, bool &timezoneExists) {
+	const INTNM::uint32_t style = flags & 0x000000ff;
+	if ((style != WTIME_FORMAT_STRING_YYYYhMMhDD) && (style != WTIME_FORMAT_STRING_YYYYhMMhDDT))
+		return false;
+	if ((date.size() < 10) || (!iso_digits(date, 0, 4, year)) || (date[4] != '-') || (!iso_digits(date, 5, 2, month)) || (date[7] != '-') || (!iso_digits(date, 8, 2, day)))
+		return false;
+	if ((year < 100) || (month < 1) || (month > 12) || (day < 1) || (day > 31))
+		return false;
+
+	hour = min = sec = 0;
+	offsetExists = timezoneExists = false;
+	if (date.size() == 10)
+		return true;
+	if (!(flags & WTIME_FORMAT_TIME))
+		return false;
+	if ((date[10] != ' ') && ((date[10] != 'T') || (style != WTIME_FORMAT_STRING_YYYYhMMhDDT)))
+		return false;
+	if ((!iso_digits(date, 11, 2, hour)) || (date.size() < 16) || (date[13] != ':') || (!iso_digits(date, 14, 2, min)))
+		return false;
+	std::size_t at = 16;
+	if ((date.size() > at) && (date[at] == ':')) {
+		if (!iso_digits(date, at + 1, 2, sec))
+			return false;
+		at += 3;
+	}
+	if ((hour > 23) || (min > 59) || (sec > 59))
+		return false;
+
+	if (date.size() == at)
+		return true;
+	if ((date[at] == 'Z') && (date.size() == at + 1)) {
+		secondOffset = 0;
+		offsetExists = true;
+		return true;
+	}
+	if ((date[at] != '+') && (date[at] != '-'))
+		return false;
+	INTNM::int32_t offsetHours, offsetMinutes;
+	if ((date.size() != at + 6) || (!iso_digits(date, at + 1, 2, offsetHours)) || (date[at + 3] != ':') || (!iso_digits(date, at + 4, 2, offsetMinutes)))
+		return false;
+	if (offsetMinutes > 59)
+		return false;
+	secondOffset = offsetHours * 3600 + offsetMinutes * 60;
+	if (date[at] == '-')
+		secondOffset = -secondOffset;
+	offsetExists = timezoneExists = true;
+	return true;
+}
+
+
+bool WTime::ParseDateTime(std::string_view lpszDate, INTNM::uint32_t flags, WorldLocation* location) {
 
 #if defined(TIMES_WINDOWS) && !defined(_NO_MFC)
 	if (flags & WTIME_FORMAT_PARSE_USING_SYSTEM)
@@ -1621,11 +1830,21 @@ bool WTime::ParseDateTime(const std::string &lpszDate, INTNM::uint32_t flags, Wo
 		std::wstring wideDate(lpszDate.begin(), lpszDate.end());
 		return systemParseDateTime(wideDate.c_str(), flags);
 #else //_UNICODE
-		return systemParseDateTime(lpszDate.c_str(), flags);
+		return systemParseDateTime(std::string(lpszDate).c_str(), flags);
 #endif //_UNICODE
 	}
 #endif
 
+	{
+		INTNM::int32_t year, month, day, hour, min, sec;
+		INTNM::int64_t secondOffset;
+		bool offsetExists, timezoneExists;
+		if (parse_iso8601(lpszDate, flags, year, month, day, hour, min, sec, secondOffset, offsetExists, timezoneExists)) {
+			setParsedDateTime(year, month, day, hour, min, sec, offsetExists ? &secondOffset : nullptr, timezoneExists, flags, location);
+			return true;
+		}
+	}
+
 	static const char delimit[] = "./\\:;-, \t";
 	static const char delimit2[] = "./\\:;-, \tT";
 	INTNM::int32_t year, month, day, hour, min, sec;
@@ -1655,11 +1874,11 @@ bool WTime::ParseDateTime(const std::string &lpszDate, INTNM::uint32_t flags, Wo
 		if ((flags & 0x000000ff) == WTIME_FORMAT_STRING_YYYYMMDDHH)
 			if (lpszDate.size() != 10)						return false;
 		std::string yr, mn, dy, hr;
-		yr = lpszDate.substr(0, 4);
-		mn = lpszDate.substr(4, 2);
-		dy = lpszDate.substr(6, 2);
+		yr = std::string(lpszDate.substr(0, 4));
+		mn = std::string(lpszDate.substr(4, 2));
+		dy = std::string(lpszDate.substr(6, 2));
 		if ((flags & 0x000000ff) == WTIME_FORMAT_STRING_YYYYMMDDHH)
-			hr = lpszDate.substr(8, 2);
+			hr = std::string(lpszDate.substr(8, 2));
 		bool rd = str2int(year, yr.c_str()); if (!rd)		return false;
 		rd = str2int(month, mn.c_str()); if (!rd)			return false;
 		rd = str2int(day, dy.c_str()); if (!rd)				return false;
@@ -1672,7 +1891,7 @@ bool WTime::ParseDateTime(const std::string &lpszDate, INTNM::uint32_t flags, Wo
 	} else {
 		const char *tok;
 		char* next = nullptr;
-		char* dateBuf = __strdup(lpszDate.c_str());
+		char* dateBuf = __strdup(std::string(lpszDate).c_str());
 
 		tok = __strtok(dateBuf, delimit, &next);
 		if (!tok) {
@@ -1857,15 +2076,22 @@ bool WTime::ParseDateTime(const std::string &lpszDate, INTNM::uint32_t flags, Wo
 		free(dateBuf);
 	}
 
+	setParsedDateTime(year, month, day, hour, min, sec, secondOffset.has_value() ? &secondOffset.value() : nullptr, timezoneExists, flags, location);
+	return true;
+}
+
+
+void WTime::setParsedDateTime(INTNM::int32_t year, INTNM::int32_t month, INTNM::int32_t day, INTNM::int32_t hour, INTNM::int32_t min, INTNM::int32_t sec,
+	const INTNM::int64_t *secondOffset, bool timezoneExists, INTNM::uint32_t flags, WorldLocation *location) {
 	if ((year >= 1600) && (year < 2900)) {
 		WTime t(year, month, day, hour, min, sec, m_tm);
-		if (secondOffset.has_value())
+		if (secondOffset)
 		{
 			int64_t offset = m_tm->m_worldLocation.m_timezone().GetTotalSeconds();
 			uint64_t intoYear = t.GetSecondsIntoYear(0);
 			if (location)
 			{
-				location->m_timezone(WTimeSpan(secondOffset.value()));
+				location->m_timezone(WTimeSpan(*secondOffset));
 				location->m_amtDST(WTimeSpan(0));
 			}
 			if (m_tm->m_worldLocation.m_startDST() != m_tm->m_worldLocation.m_endDST())
@@ -1883,7 +2109,7 @@ bool WTime::ParseDateTime(const std::string &lpszDate, INTNM::uint32_t flags, Wo
 						offset += m_tm->m_worldLocation.m_amtDST().GetTotalSeconds();
 				}
 			}
-			offset -= secondOffset.value();
+			offset -= *secondOffset;
 			if (offset)
 				t += WTimeSpan(offset);
 		}
@@ -1900,7 +2126,69 @@ bool WTime::ParseDateTime(const std::string &lpszDate, INTNM::uint32_t flags, Wo
 
 		m_time = t.m_time - (atm - m_time);
 	}
-	return true;
+}
+
+
+// fold one more difference between consecutive rows into a step, where -1 is no differences yet and 0 is irregular
+static inline void merge_step(INTNM::int64_t &step, INTNM::int64_t difference) {
+	if (step == -1)
+		step = (difference > 0) ? difference : 0;
+	else if (difference != step)
+		step = 0;
+}
+
+
+WTimeParseResult WTime::ParseDateTimes(const char *buffer, const std::size_t *offsets, std::size_t count, const WTimeManager *tm, INTNM::uint32_t flags,
+	INTNM::uint64_t *times, INTNM::uint64_t *failures) {
+	constexpr std::size_t CHUNK = 4096;					// a multiple of 64 so no two threads write to the same word of failures
+	const std::ptrdiff_t chunks = (std::ptrdiff_t)((count + CHUNK - 1) / CHUNK);
+	std::vector<INTNM::int64_t> steps(chunks);
+	std::size_t failed = 0;
+
+	#pragma omp parallel for schedule(dynamic) reduction(+:failed)
+	for (std::ptrdiff_t chunk = 0; chunk < chunks; chunk++) {
+		const std::size_t first = chunk * CHUNK, last = std::min(first + CHUNK, count);
+		if (failures)
+			memset(failures + first / 64, 0, ((last + 63) / 64 - first / 64) * sizeof(INTNM::uint64_t));
+
+		INTNM::int64_t step = -1;
+		for (std::size_t i = first; i < last; i++) {
+			std::size_t end = offsets[i + 1];
+			while (end > offsets[i]) {
+				const char c = buffer[end - 1];
+				if ((c != ' ') && (c != '\t') && (c != '\r') && (c != '\n') && (c != ','))
+					break;
+				end--;
+			}
+
+			WTime time(tm);
+			if ((time.ParseDateTime(std::string_view(buffer + offsets[i], end - offsets[i]), flags)) && (time.m_time != (INTNM::uint64_t)-1)) {
+				times[i] = time.m_time;
+				if ((i > first) && (step != 0))
+					merge_step(step, (INTNM::int64_t)(times[i] - times[i - 1]));
+			} else {
+				times[i] = (INTNM::uint64_t)-1;
+				if (failures)
+					failures[i / 64] |= 1ULL << (i % 64);
+				failed++;
+				step = 0;
+			}
+		}
+		steps[chunk] = step;
+	}
+
+	WTimeParseResult result = { failed, 0 };
+	if ((!failed) && (count > 1)) {
+		INTNM::int64_t step = -1;
+		for (std::ptrdiff_t chunk = 0; (chunk < chunks) && (step != 0); chunk++) {
+			if (chunk)									// across the boundary with the previous chunk
+				merge_step(step, (INTNM::int64_t)(times[chunk * CHUNK] - times[chunk * CHUNK - 1]));
+			if (steps[chunk] != -1)
+				merge_step(step, steps[chunk]);
+		}
+		result.m_step = (step > 0) ? step : 0;
+	}
+	return result;
 }
 
 
@@ -0,0 +1,236 @@
+/**
+ * TimezoneGrid.cpp
+ *
+ * Copyright 2016-2023 Heartland Software Solutions Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the license at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the LIcense is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TimezoneGrid.h"
+#include "TimeZoneMapper.h"
+
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+using namespace HSS_Time;
+
+
+static const char GRID_MAGIC[8] = { 'W', 'T', 'T', 'Z', 'G', 'R', 'I', 'D' };
+constexpr std::uint64_t GRID_MAX_CELLS = 1ULL << 28;
+
+
+TimezoneGrid::TimezoneGrid()
+	: m_south(0.0),
+	  m_west(0.0),
+	  m_latitudeStep(0.0),
+	  m_longitudeStep(0.0),
+	  m_rows(0),
+	  m_columns(0),
+	  m_set(0) {
+}
+
+
+void TimezoneGrid::clear() {
+	m_rows = m_columns = 0;
+	m_zones.clear();
+	m_cells.clear();
+}
+
+
+bool TimezoneGrid::Build(double south, double west, double north, double east, std::uint32_t rows, std::uint32_t columns, INTNM::int16_t set) {
+	clear();
+	if ((!rows) || (!columns) || ((std::uint64_t)rows * columns > GRID_MAX_CELLS) || (!(north > south)) || (!(east > west)))
+		return false;
+
+	m_south = south;
+	m_west = west;
+	m_latitudeStep = (north - south) / rows;
+	m_longitudeStep = (east - west) / columns;
+	m_set = (set == -1) ? 0 : set;
+
+	// resolve every cell corner, then every cell centre, in one batch so shared corners and repeats are only looked up once
+	const std::size_t corners = (std::size_t)(rows + 1) * (columns + 1);
+	const std::size_t count = corners + (std::size_t)rows * columns;
+	std::vector<double> latitude(count), longitude(count);
+	std::size_t i = 0;
+	for (std::uint32_t r = 0; r <= rows; r++)
+		for (std::uint32_t c = 0; c <= columns; c++, i++) {
+			latitude[i] = south + r * m_latitudeStep;
+			longitude[i] = west + c * m_longitudeStep;
+		}
+	for (std::uint32_t r = 0; r < rows; r++)
+		for (std::uint32_t c = 0; c < columns; c++, i++) {
+			latitude[i] = south + (r + 0.5) * m_latitudeStep;
+			longitude[i] = west + (c + 0.5) * m_longitudeStep;
+		}
+	std::vector<const TimeZoneInfo*> zones(count);
+	std::unique_ptr<bool[]> valid(new bool[count]);
+	WorldLocation::TimeZoneFromLatLon(latitude.data(), longitude.data(), count, m_set, zones.data(), valid.get());
+
+	std::unordered_map<const TimeZoneInfo*, std::uint16_t> indices;
+	auto index_of = [this, &indices](const TimeZoneInfo* tzi) -> std::uint16_t {
+		if (!tzi)
+			return NO_ZONE;
+		auto found = indices.find(tzi);
+		if (found != indices.end())
+			return found->second;
+		if (m_zones.size() >= NO_ZONE)
+			return BORDER;				// out of indices, the exact lookup still works
+		std::uint16_t index = (std::uint16_t)m_zones.size();
+		m_zones.push_back(tzi);
+		indices.emplace(tzi, index);
+		return index;
+	};
+
+	m_cells.resize((std::size_t)rows * columns);
+	for (std::uint32_t r = 0; r < rows; r++)
+		for (std::uint32_t c = 0; c < columns; c++) {
+			const std::size_t corner = (std::size_t)r * (columns + 1) + c;
+			const TimeZoneInfo* centre = zones[corners + (std::size_t)r * columns + c];
+			bool border = (zones[corner] != centre) || (zones[corner + 1] != centre) ||
+				(zones[corner + columns + 1] != centre) || (zones[corner + columns + 2] != centre);
+			m_cells[(std::size_t)r * columns + c] = border ? BORDER : index_of(centre);
+		}
+
+	m_rows = rows;
+	m_columns = columns;
+	return true;
+}
+
+
+const TimeZoneInfo* TimezoneGrid::Lookup(double latitude, double longitude, bool* valid) const {
+	double row = std::floor((latitude - m_south) / m_latitudeStep);
+	double column = std::floor((longitude - m_west) / m_longitudeStep);
+	if ((row >= 0.0) && (row < m_rows) && (column >= 0.0) && (column < m_columns)) {
+		std::uint16_t cell = m_cells[(std::size_t)row * m_columns + (std::size_t)column];
+		if (!(cell & BORDER)) {
+			const TimeZoneInfo* tzi = (cell == NO_ZONE) ? nullptr : m_zones[cell];
+			if (valid)
+				*valid = (tzi != nullptr);
+			return tzi;
+		}
+	}
+	return WorldLocation::TimeZoneFromLatLon(latitude, longitude, m_set, valid);
+}
+
+
+bool TimezoneGrid::IsBorder(std::uint32_t row, std::uint32_t column) const {
+	if ((row >= m_rows) || (column >= m_columns))
+		return true;
+	return (m_cells[(std::size_t)row * m_columns + column] & BORDER) != 0;
+}
+
+
+std::uint64_t TimezoneGrid::BorderCount() const {
+	std::uint64_t count = 0;
+	for (auto cell : m_cells)
+		if (cell & BORDER)
+			count++;
+	return count;
+}
+
+
+template<typename T>
+static void write_value(std::ostream& out, const T& value) {
+	out.write((const char*)&value, sizeof(T));
+}
+
+
+template<typename T>
+static bool read_value(std::istream& in, T& value) {
+	return (bool)in.read((char*)&value, sizeof(T));
+}
+
+
+// values are written in the machine's byte order, a grid is a cache for later runs rather than an exchange format
+bool TimezoneGrid::Save(std::ostream& out) const {
+	out.write(GRID_MAGIC, sizeof(GRID_MAGIC));
+	write_value(out, VERSION);
+	write_value(out, m_rows);
+	write_value(out, m_columns);
+	write_value(out, m_set);
+	write_value(out, m_south);
+	write_value(out, m_west);
+	write_value(out, m_latitudeStep);
+	write_value(out, m_longitudeStep);
+	write_value(out, (std::uint32_t)m_zones.size());
+	for (auto tzi : m_zones) {
+		std::uint16_t length = (std::uint16_t)strlen(tzi->m_name);
+		write_value(out, length);
+		out.write(tzi->m_name, length);
+	}
+	out.write((const char*)m_cells.data(), m_cells.size() * sizeof(std::uint16_t));
+	return (bool)out;
+}
+
+
+bool TimezoneGrid::Load(std::istream& in) {
+	clear();
+	// a damaged file leaves the grid empty, not half loaded
+	auto fail = [this]() {
+		clear();
+		return false;
+	};
+
+	char magic[sizeof(GRID_MAGIC)];
+	std::uint32_t version, rows, columns, zone_count;
+	if ((!in.read(magic, sizeof(magic))) || (memcmp(magic, GRID_MAGIC, sizeof(magic))))
+		return fail();
+	if ((!read_value(in, version)) || (version != VERSION))
+		return fail();
+	if ((!read_value(in, rows)) || (!read_value(in, columns)) || (!read_value(in, m_set)) ||
+	    (!read_value(in, m_south)) || (!read_value(in, m_west)) || (!read_value(in, m_latitudeStep)) || (!read_value(in, m_longitudeStep)) ||
+	    (!read_value(in, zone_count)))
+		return fail();
+	if ((!rows) || (!columns) || ((std::uint64_t)rows * columns > GRID_MAX_CELLS) || (zone_count > NO_ZONE) ||
+	    (!(m_latitudeStep > 0.0)) || (!(m_longitudeStep > 0.0)))
+		return fail();
+
+	std::string name;
+	for (std::uint32_t i = 0; i < zone_count; i++) {
+		std::uint16_t length;
+		if (!read_value(in, length))
+			return fail();
+		name.resize(length);
+		if (!in.read(&name[0], length))
+			return fail();
+		// the tzdb throws for a name it has never heard of, which is what a damaged or foreign file gives it
+		const TimeZoneInfo* tzi;
+		try {
+			tzi = TimezoneMapper::fromName(name.c_str(), m_set);
+		}
+		catch (std::exception&) {
+			return fail();
+		}
+		if (!tzi)
+			return fail();
+		m_zones.push_back(tzi);
+	}
+
+	m_cells.resize((std::size_t)rows * columns);
+	if (!in.read((char*)m_cells.data(), m_cells.size() * sizeof(std::uint16_t)))
+		return fail();
+	for (auto cell : m_cells)
+		if ((!(cell & BORDER)) && (cell != NO_ZONE) && (cell >= zone_count))
+			return fail();
+
+	m_rows = rows;
+	m_columns = columns;
+	return true;
+}
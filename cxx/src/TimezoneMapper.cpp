@@ -24,6 +24,11 @@
 #include <sstream>
 #include <vector>
 #include <cstring>
+#include <cctype>
+#include <cmath>
+#include <algorithm>
+#include <system_error>
+#include <thread>
 #ifdef HAVE_CSTDLIB
 #include <cstdlib>
 #elif defined(HAVE_STDLIB_H)
@@ -51,18 +56,138 @@
 #include "open/tzdb-2021e-src/version.h"
 #include "open/tzdb-2021e-src/windowsZones.h"
 
+// the snapshot image compiled into the library, generated at build time by WTimeTzSnapshot
+extern const unsigned char tzsnapshot_bin[];
+extern const unsigned int tzsnapshot_bin_size;
+
 using namespace HSS_Time;
+using namespace HSS_Time_Private;
+
+
+constexpr int OPEN_TIMEZONE_ID = 0x80000;									// matching the constexpr def'n's in worldlocation.cpp
+constexpr bool IS_OPEN(int id) { return (OPEN_TIMEZONE_ID & id) != 0; }
 
 
 ZoneDetect* TimezoneMapper::cd = nullptr;
 std::vector<::TimeZoneInfo*> TimezoneMapper::timezones;
 CThreadSemaphore TimezoneMapper::lock;
+CThreadSemaphore TimezoneMapper::tzdbLock;
+std::atomic<bool> TimezoneMapper::tzdbLoaded(false);
+std::atomic<bool> TimezoneMapper::tzdbLazy(false);
+std::atomic<std::uint32_t> TimezoneMapper::tzdbFiles(0);
+TzSnapshot TimezoneMapper::snapshot;
+std::atomic<bool> TimezoneMapper::initialized(false);
+std::atomic<TimezoneMapper::Registry*> TimezoneMapper::registry(new TimezoneMapper::Registry(256));
+std::atomic<std::uint64_t> TimezoneMapper::tileCache[TimezoneMapper::TILE_CACHE_SIZE];
+std::atomic<std::uint64_t> TimezoneMapper::tileConfig(10000);				// 0.01 degrees, roughly 1km
+std::atomic<std::uint64_t> TimezoneMapper::tileHits(0);
+std::atomic<std::uint64_t> TimezoneMapper::tileMisses(0);
+std::unordered_map<std::string, const HSS_Time::TimeZoneTransitions*> TimezoneMapper::transitionTables;
+std::atomic<const HSS_Time::TimeZoneInfo*> TimezoneMapper::zoneMemo[TimezoneMapper::ZONE_MEMO_SIZE * 2];
+std::atomic<bool> TimezoneMapper::prewarmStarted(false);
+std::string TimezoneMapper::databasePath;
+
+
+// the prewarm thread, left for finishPrewarm to join. It's never destroyed otherwise, a static std::thread would have to be
+// joined from a static destructor which deadlocks under the loader lock when the library is a DLL.
+static std::atomic<std::thread*> prewarmThread(nullptr);
+
+
+// layout of a tile cache slot, everything below TILE_ZONE_SHIFT is the key
+constexpr std::uint64_t TILE_VALID = 0x1;
+constexpr int TILE_EPOCH_SHIFT = 1;		// 5 bits
+constexpr int TILE_SET_SHIFT = 6;		// 1 bit
+constexpr int TILE_LAT_SHIFT = 7;		// 18 bits, enough for 180 degrees at 0.001
+constexpr int TILE_LON_SHIFT = 25;		// 19 bits, enough for 360 degrees at 0.001
+constexpr int TILE_ZONE_SHIFT = 44;		// 20 bits, index into the registry
+constexpr std::uint64_t TILE_KEY_MASK = (1ULL << TILE_ZONE_SHIFT) - 1;
+constexpr std::uint32_t TILE_MIN_RESOLUTION = 1000;			// micro-degrees
+constexpr std::uint32_t TILE_MAX_RESOLUTION = 10000000;
+constexpr int TILE_HASH_SHIFT = 64 - 16;
 
 static double RADIAN_TO_DEGREE(const double X) {
 	return (X * 180.0) * 0.318309886183790671537768;
 }
 
 
+// FNV-1a over the lower case name so lookups stay case insensitive like the stricmp they replace
+static std::uint32_t name_hash(const char* name) {
+	std::uint32_t hash = 2166136261u;
+	while (*name) {
+		hash ^= (std::uint32_t)tolower((unsigned char)*name++);
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+
+TimezoneMapper::Registry::Registry(std::uint32_t capacity)
+	: m_capacity(capacity),
+	  m_count(0),
+	  m_byId(new std::atomic<const HSS_Time::TimeZoneInfo*>[capacity / 2]()),
+	  m_byName(new std::atomic<const HSS_Time::TimeZoneInfo*>[capacity]()) {
+}
+
+
+const HSS_Time::TimeZoneInfo* TimezoneMapper::findName(const char* name, INTNM::int16_t set) {
+	const Registry* reg = registry.load(std::memory_order_acquire);
+	std::uint32_t mask = reg->m_capacity - 1;
+	for (std::uint32_t i = name_hash(name) & mask; ; i = (i + 1) & mask) {
+		const HSS_Time::TimeZoneInfo* tzi0 = reg->m_byName[i].load(std::memory_order_acquire);
+		if (!tzi0)
+			return nullptr;
+		if (!stricmp(name, tzi0->m_name))
+			if (set == (tzi0->m_dst.GetTotalSeconds() != 0))
+				return tzi0;
+	}
+}
+
+
+const HSS_Time::TimeZoneInfo* TimezoneMapper::findTz(const date::sys_info& si, const char* name) {
+	const Registry* reg = registry.load(std::memory_order_acquire);
+	std::uint32_t mask = reg->m_capacity - 1;
+	for (std::uint32_t i = name_hash(name) & mask; ; i = (i + 1) & mask) {
+		const HSS_Time::TimeZoneInfo* tzi0 = reg->m_byName[i].load(std::memory_order_acquire);
+		if (!tzi0)
+			return nullptr;
+		if ((si.offset - si.save).count() == tzi0->m_timezone.GetTotalSeconds())
+			if (si.offset.count() == (tzi0->m_timezone + tzi0->m_dst).GetTotalSeconds())
+				if (!strcmp(si.abbrev.c_str(), tzi0->m_code))
+					if (!strcmp(name, tzi0->m_name))
+						return tzi0;
+	}
+}
+
+
+void TimezoneMapper::publishTz(const HSS_Time::TimeZoneInfo* tzi) {
+	auto insert_name = [](Registry* reg, const HSS_Time::TimeZoneInfo* tzi0) {
+		std::uint32_t mask = reg->m_capacity - 1;
+		std::uint32_t i = name_hash(tzi0->m_name) & mask;
+		while (reg->m_byName[i].load(std::memory_order_relaxed))
+			i = (i + 1) & mask;
+		reg->m_byName[i].store(tzi0, std::memory_order_release);
+	};
+
+	Registry* reg = registry.load(std::memory_order_relaxed);
+	std::uint32_t count = reg->m_count.load(std::memory_order_relaxed);
+	if ((count + 1) * 2 > reg->m_capacity) {
+		Registry* grown = new Registry(reg->m_capacity * 2);
+		for (std::uint32_t i = 0; i < count; i++) {
+			const HSS_Time::TimeZoneInfo* tzi0 = reg->m_byId[i].load(std::memory_order_relaxed);
+			grown->m_byId[i].store(tzi0, std::memory_order_relaxed);
+			insert_name(grown, tzi0);
+		}
+		grown->m_count.store(count, std::memory_order_relaxed);
+		grown->m_retired.reset(reg);
+		registry.store(grown, std::memory_order_release);
+		reg = grown;
+	}
+	reg->m_byId[count].store(tzi, std::memory_order_release);
+	insert_name(reg, tzi);
+	reg->m_count.store(count + 1, std::memory_order_release);
+}
+
+
 const HSS_Time::TimeZoneInfo* TimezoneMapper::fromName(const char *name, INTNM::int16_t set) {
 	using namespace std;
 	using namespace std::chrono;
@@ -70,44 +195,37 @@ const HSS_Time::TimeZoneInfo* TimezoneMapper::fromName(const char *name, INTNM::
 
 	initTz();
 
+	const HSS_Time::TimeZoneInfo* found = findName(name, set);
+	if (found)
+		return found;
+
 	CThreadSemaphoreEngage engage(&lock, true);
 
-	for (auto tzi0 : timezones) {
-		if (!stricmp(name, tzi0->m_name)) {
-			if (set == (tzi0->m_dst.GetTotalSeconds() != 0))
-				return tzi0;
-		}
-	}
+	found = findName(name, set);				// may have been added while we waited on the lock
+	if (found)
+		return found;
 
-	date::sys_info infos, infod, tmp;
+	date::sys_info infos, infod;
+	const char* canonical;
 
 	std::string tz_name;
 #ifdef _WIN32
-	if (tzdb::native_to_standard_timezone_name(name, tz_name))
-		name = tz_name.c_str();
-#endif
-	auto tz = date::locate_zone(name);
-	if (tz) {
-		infos = tz->get_info(date::sys_days{ 2022_y / jan / 2 });
-		infod = tz->get_info(date::sys_days{ 2022_y / jul / 2 });
-
-		if (infos.save.count()) {	// this can occur in the southern hemisphere
-			tmp = infos;
-			infos = infod;
-			infod = tmp;
-		}
-
-		const HSS_Time::TimeZoneInfo* tzi;
-		if (set == -1)
-			set = 0;
-		if (set)
-			tzi = addTz(infod, name);
-		else
-			tzi = addTz(infos, name);
-		return tzi;
+	if (!snapshot.find(name, nullptr, nullptr)) {
+		loadTzdb();
+		if (tzdb::native_to_standard_timezone_name(name, tz_name))
+			name = tz_name.c_str();
 	}
-	weak_assert(false);
-	return nullptr;
+#endif
+	sampleZone(name, &canonical, &infos, &infod);
+
+	const HSS_Time::TimeZoneInfo* tzi;
+	if (set == -1)
+		set = 0;
+	if (set)
+		tzi = addTz(infod, name);
+	else
+		tzi = addTz(infos, name);
+	return tzi;
 }
 
 
@@ -118,10 +236,11 @@ const HSS_Time::TimeZoneInfo* TimezoneMapper::fromId(std::uint32_t id, INTNM::in
 
 	initTz();
 
-	CThreadSemaphoreEngage engage(&lock, true);
-
-	for (auto tzi0 : timezones) {
-		if (id == tzi0->m_id) {
+	if (IS_OPEN(id)) {
+		const Registry* reg = registry.load(std::memory_order_acquire);
+		std::uint32_t index = id - OPEN_TIMEZONE_ID;
+		if (index < reg->m_count.load(std::memory_order_acquire)) {
+			const HSS_Time::TimeZoneInfo* tzi0 = reg->m_byId[index].load(std::memory_order_acquire);
 			int dst = tzi0->m_dst.GetTotalSeconds();
 			if (set == -1)
 				set = 0;
@@ -134,27 +253,55 @@ const HSS_Time::TimeZoneInfo* TimezoneMapper::fromId(std::uint32_t id, INTNM::in
 }
 
 
-constexpr int OPEN_TIMEZONE_ID = 0x80000;									// matching the constexpr def'n's in worldlocation.cpp
-constexpr bool IS_OPEN(int id) { return (OPEN_TIMEZONE_ID & id) != 0; }
+// must be called with lock held
+const HSS_Time::TimeZoneTransitions* TimezoneMapper::transitionsFor(const std::string& name) {
+	auto found = transitionTables.find(name);
+	if (found != transitionTables.end())
+		return found->second;
+
+	HSS_Time::TimeZoneTransitions* transitions = new HSS_Time::TimeZoneTransitions();
+	if (!snapshot.find(name, nullptr, transitions)) {
+		loadTzdb(name);
+		std::vector<std::uint64_t> times;
+		std::vector<HSS_Time::TimeZoneOffset> offsets;
+		std::vector<std::string> abbrevs;
+		const std::uint64_t end = TzSnapshot::walk(date::locate_zone(name), TzSnapshot::tableEnd(), times, offsets, abbrevs);
+
+		std::uint64_t* table_times = new std::uint64_t[times.size()];
+		std::copy(times.begin(), times.end(), table_times);
+		HSS_Time::TimeZoneOffset* table_offsets = new HSS_Time::TimeZoneOffset[offsets.size()];
+		std::copy(offsets.begin(), offsets.end(), table_offsets);
+		const char** table_abbrevs = new const char*[abbrevs.size()];
+		for (std::size_t i = 0; i < abbrevs.size(); i++)
+			table_abbrevs[i] = strdup(abbrevs[i].c_str());
+
+		transitions->m_count = (std::uint32_t)times.size();
+		transitions->m_times = table_times;
+		transitions->m_offsets = table_offsets;
+		transitions->m_abbrevs = table_abbrevs;
+		transitions->m_end = end;
+	}
+	transitionTables.emplace(name, transitions);
+	return transitions;
+}
 
 
+// must be called with lock held
 const HSS_Time::TimeZoneInfo* TimezoneMapper::addTz(const date::sys_info& si, const std::string& name) {
-	for (auto tzi0 : timezones) {
-		if ((si.offset - si.save).count() == tzi0->m_timezone.GetTotalSeconds())
-			if (si.offset.count() == (tzi0->m_timezone + tzi0->m_dst).GetTotalSeconds())
-				if (!strcmp(si.abbrev.c_str(), tzi0->m_code))
-					if (!strcmp(name.c_str(), tzi0->m_name))
-						return tzi0;
-	}
+	const HSS_Time::TimeZoneInfo* found = findTz(si, name.c_str());
+	if (found)
+		return found;
 	TimeZoneInfo *tzi = new TimeZoneInfo();
 	tzi->m_code = strdup(si.abbrev.c_str());
 	tzi->m_dst = WTimeSpan(std::chrono::seconds(si.save).count());
 	tzi->m_timezone = WTimeSpan((si.offset - si.save).count());
 	tzi->m_name = strdup(name.c_str());
 	tzi->m_id = OPEN_TIMEZONE_ID + timezones.size();	// different offset from STD_TIMEZONE_ID, DST_TIMEZONE_ID, MIL_TIMEZONE_ID
+	tzi->m_transitions = transitionsFor(name);
 	if (timezones.capacity() == timezones.size())
 		timezones.reserve(timezones.capacity() + 128);
 	timezones.push_back(tzi);
+	publishTz(tzi);
 	return tzi;
 }
 
@@ -175,32 +322,396 @@ static bool same_sys_info(const date::sys_info& s0, const date::sys_info& s1) {
 
 
 bool TimezoneMapper::initTz() {
+	if (initialized.load(std::memory_order_acquire))
+		return true;
+
 	CThreadSemaphoreEngage engage(&lock, true);
 	if (!cd) {
-		cd = ZDOpenDatabaseFromMemory((void*)timezone21_bin, timezone21_bin_size);
+		// an external database is mapped read only, so its pages are shared with every other process using the same file
+		// and it can be updated without rebuilding, the embedded copy is used if there isn't one or it won't open
+		std::string path = databasePath;
+		if (path.empty()) {
+			const char* env_path = getenv("WTIME_ZONEDETECT_DB");
+			if (env_path)
+				path = env_path;
+		}
+		if (!path.empty()) {
+			cd = ZDOpenDatabase(path.c_str());
+			weak_assert(cd);
+		}
+		if (!cd)
+			cd = ZDOpenDatabaseFromMemory((void*)timezone21_bin, timezone21_bin_size);
 		if (!cd)
 			return false;
 
-		date::add_inmemory_file(africa, africa_size);
-		date::add_inmemory_file(antarctica, antarctica_size);
-		date::add_inmemory_file(asia, asia_size);
-		date::add_inmemory_file(australasia, australasia_size);
-		date::add_inmemory_file(backward, backward_size);
-		date::add_inmemory_file(etcetera, etcetera_size);
-		date::add_inmemory_file(europe, europe_size);
-		date::add_inmemory_file(leapseconds, leapseconds_size);
-		date::add_inmemory_file(northamerica, northamerica_size);
-		date::add_inmemory_file(southamerica, southamerica_size);
+		// the tzdb text is only parsed if there's no snapshot, or when a zone the snapshot doesn't have is needed
+		const char* use_snapshot = getenv("WTIME_TZ_SNAPSHOT");
+		bool opened = false;
+		if ((!use_snapshot) || (strcmp(use_snapshot, "0")))
+			opened = snapshot.open(tzsnapshot_bin, tzsnapshot_bin_size);
+		if ((!opened) && (!tzdbLazy.load(std::memory_order_relaxed)))
+			loadTzdb();
+		initialized.store(true, std::memory_order_release);
+	}
+	return true;
+}
+
+
+struct TzdbFile {
+	const unsigned char* m_text;
+	const unsigned int* m_size;
+};
+
+// every tzdb source file, in the order of TimezoneMapper's TZDB_ bits
+static const TzdbFile TZDB_FILES[] = {
+	{ africa, &africa_size },
+	{ antarctica, &antarctica_size },
+	{ asia, &asia_size },
+	{ australasia, &australasia_size },
+	{ etcetera, &etcetera_size },
+	{ europe, &europe_size },
+	{ northamerica, &northamerica_size },
+	{ southamerica, &southamerica_size },
+	{ backward, &backward_size },
+	{ leapseconds, &leapseconds_size }
+};
+constexpr std::uint32_t TZDB_FILE_COUNT = sizeof(TZDB_FILES) / sizeof(TZDB_FILES[0]);
+constexpr std::uint32_t TZDB_ALL = (1 << TZDB_FILE_COUNT) - 1;
+static_assert(TimezoneMapper::TZDB_LEAPSECONDS == 1 << (TZDB_FILE_COUNT - 1), "TZDB_FILES and the TZDB_ bits are out of step");
+
+
+// call fn(fields, count, continuation) for each line of a tzdb file that isn't blank or a comment, stopping when it returns true
+template<typename Fn>
+static bool tzdb_each_line(const TzdbFile& file, Fn fn) {
+	const char* p = (const char*)file.m_text;
+	const char* end = p + *file.m_size;
+	std::string_view fields[8];
+	while (p < end) {
+		const char* eol = (const char*)memchr(p, '\n', end - p);
+		if (!eol)
+			eol = end;
+		bool continuation = (*p == ' ') || (*p == '\t');
+		std::size_t count = 0;
+		for (const char* q = p; (q < eol) && (*q != '#') && (count < 8); ) {
+			if ((*q == ' ') || (*q == '\t') || (*q == '\r')) {
+				q++;
+				continue;
+			}
+			const char* field = q;
+			while ((q < eol) && (*q != ' ') && (*q != '\t') && (*q != '\r') && (*q != '#'))
+				q++;
+			fields[count++] = std::string_view(field, q - field);
+		}
+		if ((count) && (fn(fields, count, continuation)))
+			return true;
+		p = eol + 1;
+	}
+	return false;
+}
+
+
+// The tzdb files that have to be registered for locate_zone(name) to work: the one with the zone, the ones with the
+// rules it uses (Antarctica/Palmer uses the Arg and Chile rules from southamerica), and
+// for a link the one with the Link line plus whatever its target needs. Most links are in backward.
+static std::uint32_t tzdb_files_for(std::string_view name, int depth = 0) {
+	if (depth > 4)
+		return 0;
+
+	for (std::uint32_t i = 0; i < TZDB_FILE_COUNT; i++) {
+		std::vector<std::string_view> rules;
+		std::string_view target;
+		bool in_zone = false, found = false;
+		tzdb_each_line(TZDB_FILES[i], [&](const std::string_view* fields, std::size_t count, bool continuation) {
+			std::string_view rule;
+			if (in_zone && continuation) {
+				if (count >= 2)
+					rule = fields[1];
+				in_zone = count > 3;				// the zone continues while there's an UNTIL column
+			}
+			else if (found)
+				return true;
+			else if ((count >= 5) && (fields[0] == "Zone") && (fields[1] == name)) {
+				found = true;
+				rule = fields[3];
+				in_zone = count > 5;
+			}
+			else if ((count >= 3) && (fields[0] == "Link") && (fields[2] == name)) {
+				target = fields[1];
+				return true;
+			}
+			if ((!rule.empty()) && (isalpha((unsigned char)rule[0])))
+				rules.push_back(rule);
+			return false;
+		});
+
+		if (!target.empty())
+			return (1 << i) | tzdb_files_for(target, depth + 1);
+		if (found) {
+			std::uint32_t files = 1 << i;
+			for (auto& rule : rules) {
+				for (std::uint32_t j = 0; j < TZDB_FILE_COUNT; j++) {
+					if (tzdb_each_line(TZDB_FILES[j], [&rule](const std::string_view* fields, std::size_t count, bool) {
+							return (count >= 2) && (fields[0] == "Rule") && (fields[1] == rule);
+						})) {
+						files |= 1 << j;
+						break;
+					}
+				}
+			}
+			return files;
+		}
+	}
+	return 0;
+}
+
+
+void TimezoneMapper::setLazyTzdb(bool lazy) {
+	tzdbLazy.store(lazy, std::memory_order_relaxed);
+}
+
+
+bool TimezoneMapper::lazyTzdb() {
+	return tzdbLazy.load(std::memory_order_relaxed);
+}
+
+
+std::uint32_t TimezoneMapper::tzdbFilesLoaded() {
+	return tzdbFiles.load(std::memory_order_acquire);
+}
+
+
+bool TimezoneMapper::tzdbFullyLoaded() {
+	return tzdbLoaded.load(std::memory_order_acquire);
+}
+
+
+// must be called with tzdbLock held, files is a mask of TZDB_FILES
+void TimezoneMapper::registerTzdb(std::uint32_t files, bool windows) {
+	std::uint32_t registered = tzdbFiles.load(std::memory_order_relaxed);
+	if (!registered) {
 		std::string _version((char *)version);
 		date::version_inmemory_file(_version);
+	}
+	for (std::uint32_t i = 0; i < TZDB_FILE_COUNT; i++)
+		if ((files & ~registered) & (1 << i))
+			date::add_inmemory_file(TZDB_FILES[i].m_text, *TZDB_FILES[i].m_size);
+	if (windows)
 		date::xml_inmemory_file(windowsZones_xml, windowsZones_xml_size);
 
+	// the first parse builds the tzdb, later ones push a new tzdb to the front of date's list so anything
+	// that was located from the old one stays valid
+	if (!registered)
 		date::get_tzdb();
-	}
+#if HAS_REMOTE_API
+	else
+		date::reload_tzdb();
+#endif
+	tzdbFiles.store(registered | files, std::memory_order_release);
+}
+
+
+bool TimezoneMapper::setDatabasePath(const std::string& path) {
+	CThreadSemaphoreEngage engage(&lock, true);
+	if (cd)
+		return false;
+	databasePath = path;
 	return true;
 }
 
 
+void TimezoneMapper::prewarm() {
+	if ((initialized.load(std::memory_order_acquire)) || (prewarmStarted.load(std::memory_order_relaxed)))
+		return;
+	bool started = false;
+	if (!prewarmStarted.compare_exchange_strong(started, true))
+		return;
+
+	try {
+		prewarmThread.store(new std::thread([]() { initTz(); }), std::memory_order_release);
+	}
+	catch (std::system_error&) {
+		prewarmStarted.store(false);			// no thread, the first lookup will initialize as it always has
+	}
+}
+
+
+const void* TimezoneMapper::snapshotImage(std::size_t* size) {
+	if (size)
+		*size = tzsnapshot_bin_size;
+	return tzsnapshot_bin;
+}
+
+
+void TimezoneMapper::finishPrewarm() {
+	std::thread* thread = prewarmThread.exchange(nullptr, std::memory_order_acq_rel);
+	if (thread) {
+		if (thread->joinable())
+			thread->join();
+		delete thread;
+	}
+}
+
+
+void TimezoneMapper::loadTzdb() {
+	if (tzdbLoaded.load(std::memory_order_acquire))
+		return;
+
+	CThreadSemaphoreEngage engage(&tzdbLock, true);
+	if (!tzdbLoaded.load(std::memory_order_relaxed)) {
+		registerTzdb(TZDB_ALL, true);
+		tzdbLoaded.store(true, std::memory_order_release);
+	}
+}
+
+
+void TimezoneMapper::loadTzdb(std::string_view zone) {
+	if (tzdbLoaded.load(std::memory_order_acquire))
+		return;
+#if HAS_REMOTE_API
+	if (tzdbLazy.load(std::memory_order_relaxed)) {
+		std::uint32_t files = tzdb_files_for(zone);
+		if (files) {
+			files |= TZDB_BACKWARD;
+			if ((tzdbFiles.load(std::memory_order_acquire) & files) == files)
+				return;
+
+			CThreadSemaphoreEngage engage(&tzdbLock, true);
+			if ((!tzdbLoaded.load(std::memory_order_relaxed)) && ((tzdbFiles.load(std::memory_order_relaxed) & files) != files))
+				registerTzdb(files, false);
+			return;
+		}
+	}
+#endif
+	// without reload_tzdb nothing can be added after the first parse, and a zone we can't place needs everything
+	loadTzdb();
+}
+
+
+void TimezoneMapper::setTileResolution(double degrees) {
+	std::uint32_t resolution;
+	if (degrees <= 0.0)
+		resolution = 0;
+	else if (degrees < TILE_MIN_RESOLUTION / 1000000.0)
+		resolution = TILE_MIN_RESOLUTION;
+	else if (degrees > TILE_MAX_RESOLUTION / 1000000.0)
+		resolution = TILE_MAX_RESOLUTION;
+	else
+		resolution = (std::uint32_t)std::lround(degrees * 1000000.0);
+
+	CThreadSemaphoreEngage engage(&lock, true);
+	std::uint64_t epoch = ((tileConfig.load(std::memory_order_relaxed) >> 32) + 1) & 0x1f;
+	tileConfig.store((epoch << 32) | resolution, std::memory_order_release);
+	for (auto& slot : tileCache)
+		slot.store(0, std::memory_order_relaxed);
+}
+
+
+double TimezoneMapper::tileResolution() {
+	return (tileConfig.load(std::memory_order_acquire) & 0xffffffff) / 1000000.0;
+}
+
+
+void TimezoneMapper::tileStatistics(std::uint64_t* hits, std::uint64_t* misses) {
+	if (hits)
+		*hits = tileHits.load(std::memory_order_relaxed);
+	if (misses)
+		*misses = tileMisses.load(std::memory_order_relaxed);
+}
+
+
+void TimezoneMapper::clearTileCache() {
+	CThreadSemaphoreEngage engage(&lock, true);
+	for (auto& slot : tileCache)
+		slot.store(0, std::memory_order_relaxed);
+	tileHits.store(0, std::memory_order_relaxed);
+	tileMisses.store(0, std::memory_order_relaxed);
+}
+
+
+constexpr std::uint64_t SAMPLE_STANDARD = 13317177600000000ULL;		// 2022-01-02 in WTime microseconds
+constexpr std::uint64_t SAMPLE_DAYLIGHT = 13332816000000000ULL;		// 2022-07-02
+
+
+// collapse a zone to the two samples the TimeZoneInfo's are built from, from the snapshot if it has the zone and from
+// the tzdb if it doesn't, infos is standard time and infod is daylight savings time
+void TimezoneMapper::sampleZone(std::string_view name, const char** canonical, date::sys_info* infos, date::sys_info* infod) {
+	using namespace date;
+
+	HSS_Time::TimeZoneTransitions transitions;
+	if (snapshot.find(name, canonical, &transitions)) {
+		for (auto sample : { std::make_pair(SAMPLE_STANDARD, infos), std::make_pair(SAMPLE_DAYLIGHT, infod) }) {
+			const HSS_Time::TimeZoneOffset& offset = transitions.find(sample.first);
+			sample.second->offset = std::chrono::seconds(offset.m_offset);
+			sample.second->save = std::chrono::duration_cast<std::chrono::minutes>(std::chrono::seconds(offset.m_save));
+			sample.second->abbrev = transitions.m_abbrevs[offset.m_abbrev];
+		}
+	}
+	else {
+		loadTzdb(name);
+		auto tz = date::locate_zone(name);
+		*canonical = tz->name().c_str();
+		*infos = tz->get_info(date::sys_days{ 2022_y / jan / 2 });
+		*infod = tz->get_info(date::sys_days{ 2022_y / jul / 2 });
+	}
+
+	if (infos->save.count())	// this can occur in the southern hemisphere
+		std::swap(*infos, *infod);
+}
+
+
+// copy part of a ZoneDetect zone name into buffer, dropping the brackets it uses around some names
+static std::size_t append_zone_part(char* buffer, std::size_t length, std::size_t size, const char* part) {
+	for (; (*part) && (length < size); part++)
+		if ((*part != '[') && (*part != ']'))
+			buffer[length++] = *part;
+	return length;
+}
+
+
+const HSS_Time::TimeZoneInfo* TimezoneMapper::zoneFromResult(const ZoneDetectResult& result, INTNM::int16_t set) {
+	using namespace date;
+
+	std::atomic<const HSS_Time::TimeZoneInfo*>* memo = nullptr;
+	if (result.metaId < ZONE_MEMO_SIZE) {
+		memo = &zoneMemo[result.metaId * 2 + (set ? 1 : 0)];
+		const HSS_Time::TimeZoneInfo* tzi = memo->load(std::memory_order_acquire);
+		if (tzi)
+			return tzi;
+	}
+
+	// ZoneDetect splits the name into a prefix (eg. "America/") and an id
+	char zonestr[128];
+	std::size_t length = 0;
+	INTNM::int32_t i;
+	for (i = 0; i < result.numFields; i++) {
+		if (!strcmp(result.fieldNames[i], "TimezoneIdPrefix")) {
+			length = append_zone_part(zonestr, length, sizeof(zonestr), result.data[i]);
+			break;
+		}
+	}
+	for (i = 0; i < result.numFields; i++) {
+		if (!strcmp(result.fieldNames[i], "TimezoneId")) {
+			length = append_zone_part(zonestr, length, sizeof(zonestr), result.data[i]);
+			break;
+		}
+	}
+
+	const char* canonical;
+	date::sys_info infos, infod;
+	sampleZone(std::string_view(zonestr, length), &canonical, &infos, &infod);
+
+	const date::sys_info& si = set ? infod : infos;
+	const HSS_Time::TimeZoneInfo* tzi = findTz(si, canonical);
+	if (!tzi) {
+		CThreadSemaphoreEngage engage(&lock, true);
+		tzi = addTz(si, canonical);
+	}
+	if (memo)
+		memo->store(tzi, std::memory_order_release);
+	return tzi;
+}
+
+
 const ::TimeZoneInfo* TimezoneMapper::getTz(const double lat, const double lng, INTNM::int16_t set, bool* valid)
 {
 	using namespace std;
@@ -209,55 +720,118 @@ const ::TimeZoneInfo* TimezoneMapper::getTz(const double lat, const double lng,
 
 	initTz();
 
-	const HSS_Time::TimeZoneInfo* tzi = nullptr;
-	float safezone;
-	date::sys_info infos, infod, tmp;
-	ZoneDetectResult* results = ZDLookup(cd, lat, lng, &safezone);
-	INTNM::int32_t index = 0, i;
-	std::string zonestr, zoneset;
-	while (results[index].lookupResult != ZD_LOOKUP_END) {
-		for (i = 0; i < results[index].numFields; i++) {
-			if (!strcmp(results[index].fieldNames[i], "TimezoneIdPrefix")) {
-				zonestr += results[index].data[i];
-				break;
-			}
-		}
-		for (i = 0; i < results[index].numFields; i++) {
-			if (!strcmp(results[index].fieldNames[i], "TimezoneId")) {
-				zonestr += results[index].data[i];
-				break;
+	if (set == -1)
+		set = 0;
+
+	// work out which tile the point is in, tiles are only used for in range coordinates when the cache is enabled
+	std::uint64_t config = tileConfig.load(std::memory_order_acquire);
+	double resolution = (config & 0xffffffff) / 1000000.0;
+	std::uint64_t key = 0;
+	std::uint32_t latIndex = 0, lonIndex = 0;
+	std::atomic<std::uint64_t>* slot = nullptr;
+	if ((resolution > 0.0) && (lat >= -90.0) && (lat <= 90.0) && (lng >= -180.0) && (lng <= 180.0)) {
+		latIndex = (std::uint32_t)((lat + 90.0) / resolution);
+		lonIndex = (std::uint32_t)((lng + 180.0) / resolution);
+		key = TILE_VALID | ((config >> 32) << TILE_EPOCH_SHIFT) | ((std::uint64_t)(set ? 1 : 0) << TILE_SET_SHIFT) |
+			((std::uint64_t)latIndex << TILE_LAT_SHIFT) | ((std::uint64_t)lonIndex << TILE_LON_SHIFT);
+		static_assert((1ULL << (64 - TILE_HASH_SHIFT)) == TILE_CACHE_SIZE, "tile hash doesn't cover the cache");
+		std::uint64_t hash = (key >> TILE_SET_SHIFT) * 0x9E3779B97F4A7C15ULL;
+		slot = &tileCache[hash >> TILE_HASH_SHIFT];
+
+		std::uint64_t entry = slot->load(std::memory_order_relaxed);
+		if ((entry & TILE_KEY_MASK) == key) {
+			const Registry* reg = registry.load(std::memory_order_acquire);
+			std::uint32_t zone = (std::uint32_t)(entry >> TILE_ZONE_SHIFT);
+			if (zone < reg->m_count.load(std::memory_order_acquire)) {
+				tileHits.fetch_add(1, std::memory_order_relaxed);
+				if (valid)
+					*valid = true;
+				return reg->m_byId[zone].load(std::memory_order_acquire);
 			}
 		}
+		tileMisses.fetch_add(1, std::memory_order_relaxed);
+	}
 
-		zonestr.erase(std::remove(zonestr.begin(), zonestr.end(), '['), zonestr.end());
-		zonestr.erase(std::remove(zonestr.begin(), zonestr.end(), ']'), zonestr.end());
+	const HSS_Time::TimeZoneInfo* tzi = nullptr;
+	float safezone = 0.0f;
+	ZoneDetectResult* results = ZDLookup(cd, (float)lat, (float)lng, &safezone);
+	if (!results) {
+		if (valid)
+			*valid = false;
+		weak_assert(false);
+		return nullptr;
+	}
+	INTNM::int32_t index = 0;
+	while (results[index].lookupResult != ZD_LOOKUP_END) {
+		tzi = zoneFromResult(results[index], set);
+		index++;
+	}
 
-		date::zoned_time<date::days> zt1{ zonestr.c_str() };
-		auto tz = zt1.get_time_zone();
+	// ZoneDetect's safezone is the distance to the closest border, measured in a space where a degree of longitude is
+	// worth half a degree of latitude, so treating both as degrees is conservative. If the farthest corner of the tile
+	// is inside that distance then every point in the tile resolves the same way.
+	if ((slot) && (tzi) && (index == 1) && (results[0].lookupResult == ZD_LOOKUP_IN_ZONE)) {
+		double lat0 = latIndex * resolution - 90.0, lon0 = lonIndex * resolution - 180.0;
+		double dlat = std::max(lat - lat0, lat0 + resolution - lat);
+		double dlon = std::max(lng - lon0, lon0 + resolution - lng);
+		if ((dlat * dlat + dlon * dlon) < ((double)safezone * (double)safezone))
+			slot->store(key | ((std::uint64_t)(tzi->m_id - OPEN_TIMEZONE_ID) << TILE_ZONE_SHIFT), std::memory_order_relaxed);
+	}
+	ZDFreeResults(results);
 
-		infos = tz->get_info(date::sys_days{ 2022_y / jan / 2 });
-		infod = tz->get_info(date::sys_days{ 2022_y / jul / 2 });
+	if (valid)
+		*valid = (tzi != nullptr);
+	weak_assert(tzi != nullptr);
+	return tzi;
+}
 
-		if (infos.save.count()) {
-			tmp = infos;
-			infos = infod;
-			infod = tmp;
-		}
 
-		if (set == -1)
-			set = 0;
-		if (set)
-			tzi = addTz(infod, tz->name());
+void TimezoneMapper::getTzBatch(const double* lat, const double* lng, std::size_t count, INTNM::int16_t set, const HSS_Time::TimeZoneInfo** tzi, bool* valid)
+{
+	initTz();
+
+	// quantize to a micro-degree (about 10cm) so duplicate and near duplicate points collapse together, then sort them so
+	// neighbouring points are resolved together and share tiles. Points that are out of range are never merged.
+	std::vector<std::pair<std::uint64_t, std::size_t>> order(count);
+	for (std::size_t i = 0; i < count; i++) {
+		if ((lat[i] >= -90.0) && (lat[i] <= 90.0) && (lng[i] >= -180.0) && (lng[i] <= 180.0)) {
+			std::uint64_t qlat = (std::uint64_t)std::llround((lat[i] + 90.0) * 1000000.0);
+			std::uint64_t qlng = (std::uint64_t)std::llround((lng[i] + 180.0) * 1000000.0);
+			order[i] = std::make_pair((qlat << 32) | qlng, i);
+		}
 		else
-			tzi = addTz(infos, tz->name());
+			order[i] = std::make_pair(0x8000000000000000ULL | i, i);
+	}
+	std::sort(order.begin(), order.end());
+
+	std::vector<std::size_t> unique;			// input index of the first point for each distinct key
+	std::vector<std::size_t> which(count);		// for each input, its entry in unique
+	unique.reserve(count);
+	for (std::size_t i = 0; i < count; i++) {
+		if ((i == 0) || (order[i].first != order[i - 1].first))
+			unique.push_back(order[i].second);
+		which[order[i].second] = unique.size() - 1;
+	}
 
-		index++;
-		if (!zoneset.empty())
-			zoneset += ',';
-		zoneset += zonestr;
-		zonestr.clear();
+	std::vector<const HSS_Time::TimeZoneInfo*> found(unique.size());
+	std::unique_ptr<bool[]> found_valid(new bool[unique.size()]);
+	#pragma omp parallel for schedule(dynamic, 64)
+	for (std::int64_t u = 0; u < (std::int64_t)unique.size(); u++) {
+		std::size_t i = unique[u];
+		// an exception can't leave an OpenMP loop (it terminates), so a point that throws (std::bad_alloc while
+		// registering a zone, say) is reported as not found
+		try {
+			found[u] = getTz(lat[i], lng[i], set, &found_valid[u]);
+		}
+		catch (...) {
+			found[u] = nullptr;
+			found_valid[u] = false;
+		}
 	}
 
-	weak_assert(tzi != nullptr);
-	return tzi;
+	for (std::size_t i = 0; i < count; i++) {
+		tzi[i] = found[which[i]];
+		if (valid)
+			valid[i] = found_valid[which[i]];
+	}
 }
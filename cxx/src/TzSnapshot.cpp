@@ -0,0 +1,296 @@
+/**
+ * TzSnapshot.cpp
+ *
+ * Copyright 2016-2023 Heartland Software Solutions Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the license at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the LIcense is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TzSnapshot.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+using namespace HSS_Time_Private;
+
+
+static const char SNAPSHOT_MAGIC[8] = { 'W', 'T', 'T', 'Z', 'S', 'N', 'A', 'P' };
+static constexpr std::uint64_t DAY_MICROSECONDS = 24ULL * 60ULL * 60ULL * 1000000ULL;
+static constexpr std::uint64_t CYCLE = (std::uint64_t)HSS_Time::CivilCalendar::DAYS_PER_ERA * DAY_MICROSECONDS;	// as TimeZoneTransitions::find repeats
+
+
+TzSnapshot::TzSnapshot()
+	: m_image(nullptr),
+	  m_header(nullptr) {
+}
+
+
+date::sys_seconds TzSnapshot::tableStart() {
+	using namespace date;
+	return date::sys_days{ year{ 1600 } / jan / 1 };			// the start of WTime
+}
+
+
+date::sys_seconds TzSnapshot::tableEnd() {
+	using namespace date;
+	return date::sys_days{ year{ 2800 } / jan / 1 };			// far enough out that the last 400 years only follow the current rules,
+																// each zone's table is cut back to where it starts repeating
+}
+
+
+bool TzSnapshot::open(const void* image, std::size_t size) {
+	m_image = nullptr;
+	m_header = nullptr;
+	m_abbrevs.clear();
+
+	if ((!image) || (size < sizeof(TzSnapshotHeader)) || (((std::uintptr_t)image) & 7))
+		return false;
+	const TzSnapshotHeader* header = (const TzSnapshotHeader*)image;
+	if ((memcmp(header->m_magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC))) || (header->m_version != VERSION))
+		return false;
+	if ((header->m_zones > size) || (header->m_links > size) || (header->m_abbrevs > size) || (header->m_strings >= size) ||
+	    (header->m_times > size) || (header->m_offsets > size) ||
+	    ((header->m_zones | header->m_links | header->m_abbrevs | header->m_times | header->m_offsets) & 7))
+		return false;
+
+	// the tables don't overlap, so each one ends where the next one in the image starts
+	const std::uint64_t tables[] = { header->m_zones, header->m_links, header->m_times, header->m_offsets, header->m_abbrevs, header->m_strings };
+	auto table_size = [&tables, size](std::uint64_t start) {
+		std::uint64_t end = size;
+		for (std::uint64_t table : tables)
+			if ((table > start) && (table < end))
+				end = table;
+		return end - start;
+	};
+	if ((header->m_zoneCount > table_size(header->m_zones) / sizeof(TzSnapshotZone)) ||
+	    (header->m_linkCount > table_size(header->m_links) / sizeof(TzSnapshotLink)) ||
+	    (header->m_abbrevCount > table_size(header->m_abbrevs) / sizeof(std::uint32_t)))
+		return false;
+
+	// every string has to end inside the pool, so its last byte has to be a nul
+	const unsigned char* bytes = (const unsigned char*)image;
+	const std::uint64_t string_size = table_size(header->m_strings);
+	if (bytes[header->m_strings + string_size - 1])
+		return false;
+
+	const std::uint64_t time_count = table_size(header->m_times) / sizeof(std::uint64_t);
+	const std::uint64_t offset_count = table_size(header->m_offsets) / sizeof(HSS_Time::TimeZoneOffset);
+	const HSS_Time::TimeZoneOffset* offsets = (const HSS_Time::TimeZoneOffset*)(bytes + header->m_offsets);
+	const TzSnapshotZone* zones = (const TzSnapshotZone*)(bytes + header->m_zones);
+	for (std::uint32_t i = 0; i < header->m_zoneCount; i++) {
+		const TzSnapshotZone& zone = zones[i];
+		const std::uint64_t end = (std::uint64_t)zone.m_first + zone.m_count;
+		if ((zone.m_name >= string_size) || (!zone.m_count) || (end > time_count) || (end > offset_count) ||
+		    (zone.m_firstAbbrev > header->m_abbrevCount) || (zone.m_end < CYCLE))
+			return false;
+		for (std::uint32_t j = zone.m_first; j < end; j++)
+			if (offsets[j].m_abbrev >= header->m_abbrevCount - zone.m_firstAbbrev)
+				return false;
+	}
+	const TzSnapshotLink* links = (const TzSnapshotLink*)(bytes + header->m_links);
+	for (std::uint32_t i = 0; i < header->m_linkCount; i++)
+		if ((links[i].m_name >= string_size) || (links[i].m_zone >= header->m_zoneCount))
+			return false;
+	const std::uint32_t* abbrevs = (const std::uint32_t*)(bytes + header->m_abbrevs);
+	for (std::uint32_t i = 0; i < header->m_abbrevCount; i++)
+		if (abbrevs[i] >= string_size)
+			return false;
+
+	m_image = bytes;
+	m_header = header;
+	m_abbrevs.resize(m_header->m_abbrevCount);
+	for (std::uint32_t i = 0; i < m_header->m_abbrevCount; i++)
+		m_abbrevs[i] = string(abbrevs[i]);
+	return true;
+}
+
+
+bool TzSnapshot::find(std::string_view name, const char** canonical, HSS_Time::TimeZoneTransitions* transitions) const {
+	if (!m_header)
+		return false;
+
+	const TzSnapshotZone* zones = (const TzSnapshotZone*)(m_image + m_header->m_zones);
+	const TzSnapshotZone* zones_end = zones + m_header->m_zoneCount;
+	const TzSnapshotZone* zone = std::lower_bound(zones, zones_end, name,
+		[this](const TzSnapshotZone& z, std::string_view n) { return n.compare(string(z.m_name)) > 0; });
+	if ((zone == zones_end) || (name != string(zone->m_name))) {
+		const TzSnapshotLink* links = (const TzSnapshotLink*)(m_image + m_header->m_links);
+		const TzSnapshotLink* links_end = links + m_header->m_linkCount;
+		const TzSnapshotLink* link = std::lower_bound(links, links_end, name,
+			[this](const TzSnapshotLink& l, std::string_view n) { return n.compare(string(l.m_name)) > 0; });
+		if ((link == links_end) || (name != string(link->m_name)))
+			return false;
+		zone = zones + link->m_zone;
+	}
+
+	if (canonical)
+		*canonical = string(zone->m_name);
+	if (transitions) {
+		transitions->m_count = zone->m_count;
+		transitions->m_times = (const std::uint64_t*)(m_image + m_header->m_times) + zone->m_first;
+		transitions->m_offsets = (const HSS_Time::TimeZoneOffset*)(m_image + m_header->m_offsets) + zone->m_first;
+		transitions->m_abbrevs = m_abbrevs.data() + zone->m_firstAbbrev;
+		transitions->m_end = zone->m_end;
+	}
+	return true;
+}
+
+
+std::uint64_t TzSnapshot::repeatingEnd(const std::uint64_t* times, const HSS_Time::TimeZoneOffset* offsets, std::size_t count,
+	std::uint64_t horizon) {
+	auto offset_at = [times, offsets, count](std::uint64_t time) -> const HSS_Time::TimeZoneOffset& {
+		return offsets[(std::upper_bound(times, times + count, time) - times) - 1];
+	};
+	auto repeats_at = [&offset_at](std::uint64_t time) {
+		const HSS_Time::TimeZoneOffset& now = offset_at(time);
+		const HSS_Time::TimeZoneOffset& before = offset_at(time - CYCLE);
+		return (now.m_offset == before.m_offset) && (now.m_save == before.m_save) && (now.m_abbrev == before.m_abbrev);
+	};
+	// both sides only change at a transition, so comparing them at each one (and at end) compares them everywhere
+	auto repeats_from = [&](std::uint64_t end) {
+		if ((end < horizon) && (!repeats_at(end)))
+			return false;
+		for (std::size_t i = 0; i < count; i++) {
+			if ((times[i] >= end) && (times[i] < horizon) && (!repeats_at(times[i])))
+				return false;
+			if ((times[i] + CYCLE >= end) && (times[i] + CYCLE < horizon) && (!repeats_at(times[i] + CYCLE)))
+				return false;
+		}
+		return true;
+	};
+
+	// once the table repeats from one year it repeats from every later one, so search for the first
+	auto year_start = [](INTNM::int32_t year) { return (std::uint64_t)HSS_Time::CivilCalendar::YearStart(year) * DAY_MICROSECONDS; };
+	INTNM::int32_t first = 2000, last = HSS_Time::CivilCalendar::CivilFromDays((std::int64_t)(horizon / DAY_MICROSECONDS)).m_year;
+	while (first < last) {
+		INTNM::int32_t middle = first + (last - first) / 2;
+		if (repeats_from(year_start(middle)))
+			last = middle;
+		else
+			first = middle + 1;
+	}
+	return std::min(year_start(first), horizon);
+}
+
+
+std::uint64_t TzSnapshot::walk(const date::time_zone* tz, const date::sys_seconds& horizon, std::vector<std::uint64_t>& times,
+	std::vector<HSS_Time::TimeZoneOffset>& offsets, std::vector<std::string>& abbrevs) {
+	const date::sys_seconds start = tableStart();
+	const std::size_t first = times.size();
+	for (date::sys_seconds t = start; t < horizon; ) {
+		date::sys_info info = tz->get_info(t);
+		auto abbrev = std::find(abbrevs.begin(), abbrevs.end(), info.abbrev);
+		if (abbrev == abbrevs.end())
+			abbrev = abbrevs.insert(abbrevs.end(), info.abbrev);
+		HSS_Time::TimeZoneOffset offset;
+		offset.m_offset = (INTNM::int32_t)info.offset.count();
+		offset.m_save = (INTNM::int16_t)std::chrono::duration_cast<std::chrono::seconds>(info.save).count();
+		offset.m_abbrev = (INTNM::uint16_t)(abbrev - abbrevs.begin());
+		if ((offsets.size() == first) || (offsets.back().m_offset != offset.m_offset) || (offsets.back().m_save != offset.m_save) || (offsets.back().m_abbrev != offset.m_abbrev)) {
+			times.push_back((std::uint64_t)(t - start).count() * 1000000ULL);
+			offsets.push_back(offset);
+		}
+		t = info.end;
+	}
+
+	// most zones only follow the same rules from 2007 or so, everything past 400 years after that is find's to repeat
+	const std::uint64_t end = repeatingEnd(times.data() + first, offsets.data() + first, times.size() - first,
+		(std::uint64_t)(horizon - start).count() * 1000000ULL);
+	const std::size_t count = std::lower_bound(times.begin() + first, times.end(), end) - times.begin();
+	times.resize(count);
+	offsets.resize(count);
+	return end;
+}
+
+
+template<typename T>
+static std::uint64_t append_table(std::vector<unsigned char>& image, const T* data, std::size_t count) {
+	image.resize((image.size() + 7) & ~(std::size_t)7);
+	std::uint64_t offset = image.size();
+	image.insert(image.end(), (const unsigned char*)data, (const unsigned char*)(data + count));
+	return offset;
+}
+
+
+std::vector<unsigned char> TzSnapshot::build(const date::tzdb& db) {
+	std::string strings;
+	std::map<std::string, std::uint32_t> string_offsets;
+	auto add_string = [&strings, &string_offsets](const std::string& s) {
+		auto it = string_offsets.find(s);
+		if (it != string_offsets.end())
+			return it->second;
+		std::uint32_t offset = (std::uint32_t)strings.size();
+		strings.append(s);
+		strings.push_back('\0');
+		string_offsets.emplace(s, offset);
+		return offset;
+	};
+
+	std::vector<const date::time_zone*> sorted_zones;
+	for (auto& zone : db.zones)
+		sorted_zones.push_back(&zone);
+	std::sort(sorted_zones.begin(), sorted_zones.end(), [](const date::time_zone* a, const date::time_zone* b) { return a->name() < b->name(); });
+
+	std::vector<TzSnapshotZone> zones;
+	std::vector<std::uint64_t> times;
+	std::vector<HSS_Time::TimeZoneOffset> offsets;
+	std::vector<std::uint32_t> abbrevs;
+	for (auto tz : sorted_zones) {
+		std::vector<std::string> zone_abbrevs;
+		TzSnapshotZone zone;
+		zone.m_name = add_string(tz->name());
+		zone.m_first = (std::uint32_t)times.size();
+		zone.m_firstAbbrev = (std::uint32_t)abbrevs.size();
+		zone.m_end = walk(tz, tableEnd(), times, offsets, zone_abbrevs);
+		zone.m_count = (std::uint32_t)times.size() - zone.m_first;
+		for (auto& abbrev : zone_abbrevs)
+			abbrevs.push_back(add_string(abbrev));
+		zones.push_back(zone);
+	}
+
+	std::vector<std::pair<std::string, std::uint32_t>> sorted_links;
+	for (auto& link : db.links) {
+		auto zone = std::lower_bound(sorted_zones.begin(), sorted_zones.end(), link.target(),
+			[](const date::time_zone* z, const std::string& n) { return z->name() < n; });
+		if ((zone != sorted_zones.end()) && ((*zone)->name() == link.target()))
+			sorted_links.emplace_back(link.name(), (std::uint32_t)(zone - sorted_zones.begin()));
+	}
+	std::sort(sorted_links.begin(), sorted_links.end());
+	std::vector<TzSnapshotLink> links;
+	for (auto& link : sorted_links) {
+		TzSnapshotLink l;
+		l.m_name = add_string(link.first);
+		l.m_zone = link.second;
+		links.push_back(l);
+	}
+
+	TzSnapshotHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.m_magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+	header.m_version = VERSION;
+	header.m_zoneCount = (std::uint32_t)zones.size();
+	header.m_linkCount = (std::uint32_t)links.size();
+	header.m_abbrevCount = (std::uint32_t)abbrevs.size();
+	strncpy(header.m_tzdbVersion, db.version.c_str(), sizeof(header.m_tzdbVersion) - 1);
+
+	std::vector<unsigned char> image(sizeof(TzSnapshotHeader));
+	header.m_zones = append_table(image, zones.data(), zones.size());
+	header.m_links = append_table(image, links.data(), links.size());
+	header.m_times = append_table(image, times.data(), times.size());
+	header.m_offsets = append_table(image, offsets.data(), offsets.size());
+	header.m_abbrevs = append_table(image, abbrevs.data(), abbrevs.size());
+	header.m_strings = append_table(image, strings.data(), strings.size());
+	memcpy(image.data(), &header, sizeof(header));
+	return image;
+}
@@ -0,0 +1,460 @@
+/**
+ * WTimeFormatter.cpp
+ *
+ * Copyright 2016-2023 Heartland Software Solutions Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the license at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the LIcense is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "WTimeFormatter.h"
+#include "types.h"
+
+#include <charconv>
+#include <cstring>
+
+using namespace HSS_Time;
+
+
+// the steps of a plan, in the order WTime::ToString writes its fields
+enum : std::uint8_t {
+	OP_LITERAL,							// followed by the character
+	OP_DAY_OF_WEEK,
+	OP_MONTH_NAME,
+	OP_YEAR,							// %d
+	OP_YEAR4,							// %04d
+	OP_MONTH2,							// %02d
+	OP_DAY2,							// %02d
+	OP_DAY_SPACED,						// %2d
+	OP_HOUR2,
+	OP_MINUTE2,
+	OP_MINUTE_ROUNDED2,					// the minute rounded on the seconds
+	OP_SECOND2,
+	OP_MICROSECONDS6,					// %06d
+	OP_CONDITIONAL_TIME,				// followed by the number of plan bytes to skip when the time of day is 0
+	OP_TIMEZONE
+};
+
+
+// an integer as printf would write it with %d, %0<width>d or %<width>d
+static char *write_int(char *p, INTNM::int64_t value, int width = 0, char pad = '0') {
+	char digits[24];
+	const bool negative = value < 0;
+	const INTNM::uint64_t magnitude = negative ? 0 - (INTNM::uint64_t)value : (INTNM::uint64_t)value;
+	const int count = (int)(std::to_chars(digits, digits + sizeof(digits), magnitude).ptr - digits);
+	int padding = width - count - (negative ? 1 : 0);
+
+	if (pad == ' ')
+		for (; padding > 0; padding--)
+			*p++ = ' ';
+	if (negative)
+		*p++ = '-';
+	for (; padding > 0; padding--)
+		*p++ = '0';
+	memcpy(p, digits, count);
+	return p + count;
+}
+
+
+// %02d, almost always two digits
+static inline char *write_2(char *p, INTNM::int32_t value) {
+	if ((INTNM::uint32_t)value < 100) {
+		p[0] = (char)('0' + value / 10);
+		p[1] = (char)('0' + value % 10);
+		return p + 2;
+	}
+	return write_int(p, value, 2);
+}
+
+
+static inline char *write_str(char *p, const char *str) {
+	const std::size_t length = strlen(str);
+	memcpy(p, str, length);
+	return p + length;
+}
+
+
+WTimeFormatter::WTimeFormatter(INTNM::uint32_t flags)
+	: m_flags(flags),
+	  m_planLength(0) {
+	if (flags & WTIME_FORMAT_ABBREV) {
+		m_months = WTimeManager::months_abbrev;
+		m_days = WTimeManager::days_abbrev;
+	} else {
+		m_months = WTimeManager::months;
+		m_days = WTimeManager::days;
+	}
+
+	const INTNM::uint32_t style = flags & 0x000000ff;
+	bool need_leading_space = false;
+	if (flags & WTIME_FORMAT_DAY_OF_WEEK) {
+		emit(OP_DAY_OF_WEEK);
+		need_leading_space = true;
+	}
+
+	if (flags & WTIME_FORMAT_DATE) {
+		if (need_leading_space)	emit(OP_LITERAL, ' ');
+		else					need_leading_space = true;
+
+		switch (style) {
+		case WTIME_FORMAT_STRING_DD_MM_YYYY:
+			emit(OP_DAY2); emit(OP_LITERAL, '/'); emit(OP_MONTH2); emit(OP_LITERAL, '/'); emit(OP_YEAR4);
+			break;
+		case WTIME_FORMAT_STRING_YYYY_MM_DD:
+			emit(OP_YEAR4); emit(OP_LITERAL, '/'); emit(OP_MONTH2); emit(OP_LITERAL, '/'); emit(OP_DAY2);
+			break;
+		case WTIME_FORMAT_STRING_MM_DD_YYYY:
+			emit(OP_MONTH2); emit(OP_LITERAL, '/'); emit(OP_DAY2); emit(OP_LITERAL, '/'); emit(OP_YEAR4);
+			break;
+		case WTIME_FORMAT_STRING_DDhMMhYYYY:
+			emit(OP_DAY2); emit(OP_LITERAL, '-'); emit(OP_MONTH2); emit(OP_LITERAL, '-'); emit(OP_YEAR4);
+			break;
+		case WTIME_FORMAT_STRING_YYYYhMMhDD:
+		case WTIME_FORMAT_STRING_YYYYhMMhDDT:
+			emit(OP_YEAR4); emit(OP_LITERAL, '-'); emit(OP_MONTH2); emit(OP_LITERAL, '-'); emit(OP_DAY2);
+			break;
+		case WTIME_FORMAT_STRING_MMhDDhYYYY:
+			emit(OP_MONTH2); emit(OP_LITERAL, '-'); emit(OP_DAY2); emit(OP_LITERAL, '-'); emit(OP_YEAR4);
+			break;
+		case WTIME_FORMAT_STRING_YYYYMMDD:
+		case WTIME_FORMAT_STRING_YYYYMMDDT:
+			emit(OP_YEAR4); emit(OP_MONTH2); emit(OP_DAY2);
+			break;
+		case WTIME_FORMAT_STRING_YYYYMMDDHH:
+			emit(OP_YEAR4); emit(OP_MONTH2); emit(OP_DAY2); emit(OP_HOUR2);
+			break;
+		default:
+			if (flags & WTIME_FORMAT_MONTH) {
+				emit(OP_MONTH_NAME);
+				if (flags & WTIME_FORMAT_DAY) {
+					emit(OP_LITERAL, ' '); emit(OP_DAY_SPACED);
+				}
+				if (flags & WTIME_FORMAT_YEAR) {
+					emit(OP_LITERAL, ','); emit(OP_LITERAL, ' '); emit(OP_YEAR);
+				}
+			} else if (flags & WTIME_FORMAT_DAY)
+				emit(OP_DAY_SPACED);
+			break;
+		}
+	}
+
+	if (flags & (WTIME_FORMAT_TIME | WTIME_FORMAT_CONDITIONAL_TIME)) {
+		std::uint8_t conditional = 0;
+		if (!(flags & WTIME_FORMAT_TIME)) {
+			emit(OP_CONDITIONAL_TIME, 0);
+			conditional = m_planLength;
+		}
+		if (((style == WTIME_FORMAT_STRING_YYYYhMMhDDT) || (style == WTIME_FORMAT_STRING_YYYYMMDDT)) && (flags & WTIME_FORMAT_DATE))
+			emit(OP_LITERAL, 'T');
+		else if (need_leading_space)
+			emit(OP_LITERAL, ' ');
+		if (flags & WTIME_FORMAT_EXCLUDE_SECONDS) {
+			emit(OP_HOUR2); emit(OP_LITERAL, ':'); emit(OP_MINUTE_ROUNDED2);
+		} else {
+			emit(OP_HOUR2); emit(OP_LITERAL, ':'); emit(OP_MINUTE2); emit(OP_LITERAL, ':'); emit(OP_SECOND2);
+			if (flags & WTIME_FORMAT_INCLUDE_USECS) {
+				emit(OP_LITERAL, '.'); emit(OP_MICROSECONDS6);
+			}
+		}
+		if (conditional)
+			m_plan[conditional - 1] = (std::uint8_t)(m_planLength - conditional);
+	}
+
+	if (flags & WTIME_FORMAT_STRING_TIMEZONE)
+		emit(OP_TIMEZONE);
+}
+
+
+void WTimeFormatter::emit(std::uint8_t op) {
+	weak_assert(m_planLength < MAX_PLAN);
+	m_plan[m_planLength++] = op;
+}
+
+
+void WTimeFormatter::emit(std::uint8_t op, std::uint8_t operand) {
+	emit(op);
+	emit(operand);
+}
+
+
+char *WTimeFormatter::write(const WTime &time, char *p) const {
+	if (time.GetTotalMicroSeconds() == (INTNM::uint64_t)-1)
+		return write_str(p, "[Time Not Set]");
+
+	const WTimeFields fields = time.Decompose(m_flags);
+	for (std::uint8_t i = 0; i < m_planLength; i++) {
+		switch (m_plan[i]) {
+		case OP_LITERAL:			*p++ = (char)m_plan[++i]; break;
+		case OP_DAY_OF_WEEK:		p = write_str(p, m_days[fields.m_dayOfWeek - 1]); break;
+		case OP_MONTH_NAME:			p = write_str(p, m_months[fields.m_month - 1]); break;
+		case OP_YEAR:				p = write_int(p, fields.m_year); break;
+		case OP_YEAR4:				p = write_int(p, fields.m_year, 4); break;
+		case OP_MONTH2:				p = write_2(p, fields.m_month); break;
+		case OP_DAY2:				p = write_2(p, fields.m_day); break;
+		case OP_DAY_SPACED:			p = write_int(p, fields.m_day, 2, ' '); break;
+		case OP_HOUR2:				p = write_2(p, fields.m_hour); break;
+		case OP_MINUTE2:			p = write_2(p, fields.m_minute); break;
+		case OP_MINUTE_ROUNDED2:	p = write_2(p, fields.m_minute + ((fields.m_second >= 30) ? 1 : 0)); break;
+		case OP_SECOND2:			p = write_2(p, fields.m_second); break;
+		case OP_MICROSECONDS6:		p = write_int(p, fields.m_microSeconds, 6); break;
+
+		case OP_CONDITIONAL_TIME:
+			i++;
+			if ((!fields.m_microSeconds) && (!fields.m_second) && (!fields.m_minute) && (!fields.m_hour))
+				i += m_plan[i];
+			break;
+
+		case OP_TIMEZONE: {
+			const WTimeManager *tm = time.GetTimeManager();
+			if (!tm)
+				break;
+			const WorldLocation &location = tm->m_worldLocation;
+			INTNM::int64_t offset = location.m_timezone().GetTotalMinutes();
+			if (location.m_startDST() != location.m_endDST()) {		// this is UTC's place in the year, as ToString has it
+				INTNM::uint64_t intoYear = time.GetSecondsIntoYear(0);
+				if (location.m_startDST() < location.m_endDST()) {
+					if (((INTNM::uint64_t)location.m_startDST().GetTotalSeconds() <= intoYear) &&
+						(intoYear < (INTNM::uint64_t)location.m_endDST().GetTotalSeconds()))
+						offset += location.m_amtDST().GetTotalMinutes();
+				} else {
+					if (((INTNM::uint64_t)location.m_startDST().GetTotalSeconds() < intoYear) ||
+						(intoYear <= (INTNM::uint64_t)location.m_endDST().GetTotalSeconds()))
+						offset += location.m_amtDST().GetTotalMinutes();
+				}
+			}
+			if (offset == 0)
+				*p++ = 'Z';
+			else {
+				if (offset < 0) {
+					*p++ = '-';
+					offset = -offset;
+				} else
+					*p++ = '+';
+				p = write_int(p, offset / 60, 2);
+				*p++ = ':';
+				p = write_int(p, offset % 60, 2);
+			}
+			break;
+		}
+		}
+	}
+	return p;
+}
+
+
+char *WTimeFormatter::write(const WTimeSpan &span, char *p) const {
+	const INTNM::int64_t total = span.GetTotalMicroSeconds();
+
+	if (m_flags & WTIME_FORMAT_STRING_TIMEZONE) {
+		if (total == 0)
+			return write_str(p, "PT0M");
+
+		INTNM::int32_t	year = (INTNM::int32_t)span.GetYears(),
+			day = (INTNM::int32_t)(span.GetDays() - ((long double)year * 365.25)),
+			hour = span.GetHours(),
+			minute = span.GetMinutes(),
+			second = span.GetSeconds(),
+			usecs = span.GetMicroSeconds();
+		if (total < 0)
+			*p++ = '-';
+		*p++ = 'P';
+		if (year < 0)	year = -year;
+		if (day < 0)	day = -day;
+		if (hour < 0)	hour = -hour;
+		if (minute < 0)	minute = -minute;
+		if (second < 0)	second = -second;
+		if (usecs < 0)	usecs = -usecs;
+
+		if (year > 0) {
+			p = write_int(p, year);
+			*p++ = 'Y';
+		}
+		if (day > 0) {
+			p = write_int(p, day);
+			*p++ = 'D';
+		}
+		if ((hour > 0) || (minute > 0) || (second > 0) || (usecs > 0)) {
+			*p++ = 'T';
+			if (hour > 0) {
+				p = write_int(p, hour);
+				*p++ = 'H';
+			}
+			if (minute > 0) {
+				p = write_int(p, minute);
+				*p++ = 'M';
+			}
+			if ((second > 0) || (usecs > 0)) {
+				p = write_int(p, second);
+				if (usecs > 0) {				// six digits without the trailing zeros
+					*p++ = '.';
+					char *digits = p;
+					p = write_int(p, usecs, 6);
+					while ((p > digits + 1) && (p[-1] == '0'))
+						p--;
+				}
+				*p++ = 'S';
+			}
+		}
+		return p;
+	}
+
+	INTNM::int32_t	year = (INTNM::int32_t)span.GetYears(),
+		day = (m_flags & WTIME_FORMAT_YEAR) ? ((INTNM::int32_t)(span.GetDays() - ((long double)year * 365.25))) : ((INTNM::int32_t)span.GetDays()),
+		hour = (m_flags & WTIME_FORMAT_DAY) ? span.GetHours() : (INTNM::int32_t)span.GetTotalHours(),
+		minute = span.GetMinutes(),
+		second = span.GetSeconds(),
+		usecs = span.GetMicroSeconds();
+	bool special_case = false;
+
+	if (total < 0) {
+		if (m_flags & WTIME_FORMAT_EXCLUDE_SECONDS) {
+			if (second <= -30)
+				minute--;
+			if (minute == -60) {
+				hour--;
+				minute = 0;
+			}
+			if (hour == -24) {
+				day--;
+				hour = 0;
+			}
+		}
+		if ((day != 0) && (m_flags & WTIME_FORMAT_DAY))
+			hour = 0 - hour;
+		if (hour == 0)
+			special_case = true;
+		minute = 0 - minute;
+		second = 0 - second;
+		usecs = 0 - usecs;
+	} else if (m_flags & WTIME_FORMAT_EXCLUDE_SECONDS) {
+		if (second >= 30)
+			minute++;
+		if (minute == 60) {
+			hour++;
+			minute = 0;
+		}
+		if (hour == 24) {
+			day++;
+			hour = 0;
+		}
+	}
+
+	// the time of day that follows the years and days, the hour is left to the caller for the special case
+	auto clock = [this, &hour, &minute, &second, &usecs](char *p) {
+		p = write_2(p, hour);
+		*p++ = ':';
+		p = write_2(p, minute);
+		if (!(m_flags & WTIME_FORMAT_EXCLUDE_SECONDS)) {
+			*p++ = ':';
+			p = write_2(p, second);
+			if (m_flags & WTIME_FORMAT_INCLUDE_USECS) {
+				*p++ = '.';
+				p = write_int(p, usecs, 6);
+			}
+		}
+		return p;
+	};
+
+	if ((!year) || (!(m_flags & WTIME_FORMAT_YEAR))) {
+		if ((!day) || (!(m_flags & WTIME_FORMAT_DAY))) {
+			if (special_case) {
+				p = write_str(p, "-0:");
+				if (m_flags & WTIME_FORMAT_EXCLUDE_SECONDS)
+					return write_int(p, minute, 2, ' ');
+				p = write_2(p, minute);
+				*p++ = ':';
+				p = write_2(p, second);
+				if (m_flags & WTIME_FORMAT_INCLUDE_USECS) {
+					*p++ = '.';
+					p = write_int(p, usecs, 6);
+				}
+				return p;
+			}
+			return clock(p);
+		}
+		if ((!hour) && (!minute) && (!second) && (m_flags & WTIME_FORMAT_CONDITIONAL_TIME)) {
+			if (day == 1)
+				return write_str(p, "1 day");
+			p = write_int(p, day);
+			return write_str(p, " days");
+		}
+		if (day == 1)
+			p = write_str(p, "1 day ");
+		else {
+			p = write_int(p, day);
+			p = write_str(p, " days ");
+		}
+		return clock(p);
+	}
+
+	if ((!day) && (!hour) && (!minute) && (!second) && (m_flags & WTIME_FORMAT_CONDITIONAL_TIME)) {
+		if (year == 1)
+			return write_str(p, "1 year");
+		p = write_int(p, year);
+		return write_str(p, " years");
+	}
+	if (year == 1)
+		p = write_str(p, "1 year ");
+	else {
+		p = write_int(p, year);
+		p = write_str(p, " years ");
+	}
+	p = write_int(p, day);
+	p = write_str(p, " days ");
+	return clock(p);
+}
+
+
+std::size_t WTimeFormatter::Format(const WTime &time, char *buffer, std::size_t size) const {
+	if (size >= MAX_LENGTH) {
+		char *end = write(time, buffer);
+		*end = '\0';
+		return end - buffer;
+	}
+	char scratch[MAX_LENGTH];
+	std::size_t length = write(time, scratch) - scratch;
+	if (size) {
+		std::size_t copy = (length < size) ? length : size - 1;
+		memcpy(buffer, scratch, copy);
+		buffer[copy] = '\0';
+	}
+	return length;
+}
+
+
+std::size_t WTimeFormatter::Format(const WTimeSpan &span, char *buffer, std::size_t size) const {
+	if (size >= MAX_LENGTH) {
+		char *end = write(span, buffer);
+		*end = '\0';
+		return end - buffer;
+	}
+	char scratch[MAX_LENGTH];
+	std::size_t length = write(span, scratch) - scratch;
+	if (size) {
+		std::size_t copy = (length < size) ? length : size - 1;
+		memcpy(buffer, scratch, copy);
+		buffer[copy] = '\0';
+	}
+	return length;
+}
+
+
+void WTimeFormatter::Append(const WTime &time, std::string &str) const {
+	char scratch[MAX_LENGTH];
+	str.append(scratch, write(time, scratch) - scratch);
+}
+
+
+void WTimeFormatter::Append(const WTimeSpan &span, std::string &str) const {
+	char scratch[MAX_LENGTH];
+	str.append(scratch, write(span, scratch) - scratch);
+}
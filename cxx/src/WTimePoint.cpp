@@ -0,0 +1,69 @@
+/**
+ * WTimePoint.cpp
+ *
+ * Copyright 2016-2023 Heartland Software Solutions Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the license at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the LIcense is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "WTimePoint.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using namespace HSS_Time;
+
+
+constexpr std::size_t RADIX_BITS = 16;
+constexpr std::size_t RADIX_SIZE = 1 << RADIX_BITS;
+constexpr std::size_t RADIX_DIGITS = 64 / RADIX_BITS;
+constexpr std::size_t RADIX_MIN_COUNT = 1024;			// below this the histograms cost more than a comparison sort
+
+
+void WTimePoint::Sort(WTimePoint *times, std::size_t count) {
+	if (count < RADIX_MIN_COUNT) {
+		std::sort(times, times + count);
+		return;
+	}
+
+	// count every digit in one pass over the data
+	std::vector<std::size_t> histogram(RADIX_DIGITS * RADIX_SIZE, 0);
+	for (std::size_t i = 0; i < count; i++) {
+		INTNM::uint64_t time = times[i].m_time;
+		for (std::size_t digit = 0; digit < RADIX_DIGITS; digit++, time >>= RADIX_BITS)
+			histogram[digit * RADIX_SIZE + (time & (RADIX_SIZE - 1))]++;
+	}
+
+	std::vector<WTimePoint> buffer(count);
+	WTimePoint *from = times, *to = buffer.data();
+	for (std::size_t digit = 0; digit < RADIX_DIGITS; digit++) {
+		std::size_t *offsets = &histogram[digit * RADIX_SIZE];
+		const std::size_t shift = digit * RADIX_BITS;
+		if (offsets[(times[0].m_time >> shift) & (RADIX_SIZE - 1)] == count)
+			continue;							// every time has the same value for this digit
+
+		std::size_t total = 0;
+		for (std::size_t bucket = 0; bucket < RADIX_SIZE; bucket++) {
+			std::size_t c = offsets[bucket];
+			offsets[bucket] = total;
+			total += c;
+		}
+		for (std::size_t i = 0; i < count; i++)
+			to[offsets[(from[i].m_time >> shift) & (RADIX_SIZE - 1)]++] = from[i];
+		std::swap(from, to);
+	}
+
+	if (from != times)
+		memcpy(times, from, count * sizeof(WTimePoint));
+}
@@ -0,0 +1,78 @@
+/**
+ * WTimeRange.cpp
+ *
+ * Copyright 2016-2023 Heartland Software Solutions Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the license at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the LIcense is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "WTimeRange.h"
+#include "types.h"
+
+using namespace HSS_Time;
+
+
+WTimeRange::WTimeRange(const WTime &begin, const WTime &end, const WTimeSpan &step)
+	: m_tm(begin.m_tm),
+	  m_start(begin.m_time),
+	  m_step(step.GetTotalMicroSeconds()),
+	  m_count(0) {
+	if ((begin.IsValid()) && (end.IsValid()) && (m_step > 0) && (end.m_time > begin.m_time))
+		m_count = (std::size_t)((end.m_time - begin.m_time + m_step - 1) / m_step);
+}
+
+
+WTimeRange::WTimeRange(const WTime &begin, const WTime &end, INTNM::int32_t iteration, INTNM::uint32_t flags)
+	: WTimeRange(begin, end, WTimeManager::TimeForIndex(iteration)) {
+	if ((!m_count) || (!m_tm) || (!(flags & (WTIME_FORMAT_AS_LOCAL | WTIME_FORMAT_AS_SOLAR))))
+		return;
+
+	// the boundary at or before a time, the same arithmetic as PurgeToDay and friends. That subtracts the time into the step
+	// at the time's offset, so when the offset changed since the boundary (DST started or ended earlier in the day) it's
+	// out by the change, and is moved back onto the boundary unless that falls in the hour DST skips.
+	const INTNM::uint64_t step = (INTNM::uint64_t)m_step;
+	auto boundary = [this, flags, step](INTNM::uint64_t time) {
+		const INTNM::uint64_t local = WTime(time, m_tm, false).adjusted_tm(flags);
+		const INTNM::uint64_t purged = time - local % step;
+		const INTNM::uint64_t purged_local = WTime(purged, m_tm, false).adjusted_tm(flags);
+		if (!(purged_local % step))
+			return purged;
+		const INTNM::uint64_t moved = purged + (local - time) - (purged_local - purged);
+		if ((moved <= time) && (!(WTime(moved, m_tm, false).adjusted_tm(flags) % step)))
+			return moved;
+		return purged;
+	};
+
+	// each time is the boundary before the middle of its step, which keeps one time per step (per local day, say) even
+	// where the offset to local time changes
+	m_start = boundary(begin.m_time);
+	if (boundary(m_start + step / 2) < begin.m_time)
+		m_start += step;
+
+	m_count = 0;
+	INTNM::uint64_t last = 0;
+	for (std::size_t index = 0; ; index++) {
+		const INTNM::uint64_t unaligned = m_start + (INTNM::uint64_t)index * step;
+		const INTNM::uint64_t time = boundary(unaligned + step / 2);
+		if (time >= end.m_time)
+			break;
+		weak_assert((!index) || (time > last));
+		const INTNM::int64_t adjust = (INTNM::int64_t)(time - unaligned);
+		if ((m_runs.empty()) || (m_runs.back().m_adjust != adjust))
+			m_runs.push_back({ index, adjust });
+		last = time;
+		m_count = index + 1;
+	}
+	if ((m_runs.size() == 1) && (!m_runs[0].m_adjust))
+		m_runs.clear();
+}
@@ -0,0 +1,79 @@
+/**
+ * TzSnapshotGenerator.cpp
+ *
+ * Copyright 2016-2023 Heartland Software Solutions Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the license at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the LIcense is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Build time tool that parses the in-memory tzdb the library is built with and writes it out as a TzSnapshot image
+// in a C++ source file, which is then compiled into the library.
+//
+// usage: WTimeTzSnapshot <output.cpp>
+
+#include "TzSnapshot.h"
+
+#include <cstdio>
+#include <string>
+
+#include "open/tzdb-2021e-src/africa.h"
+#include "open/tzdb-2021e-src/antarctica.h"
+#include "open/tzdb-2021e-src/asia.h"
+#include "open/tzdb-2021e-src/australasia.h"
+#include "open/tzdb-2021e-src/backward.h"
+#include "open/tzdb-2021e-src/etcetera.h"
+#include "open/tzdb-2021e-src/europe.h"
+#include "open/tzdb-2021e-src/leapseconds.h"
+#include "open/tzdb-2021e-src/northamerica.h"
+#include "open/tzdb-2021e-src/southamerica.h"
+#include "open/tzdb-2021e-src/version.h"
+#include "open/tzdb-2021e-src/windowsZones.h"
+
+
+int main(int argc, char* argv[])
+{
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s <output.cpp>\n", argv[0]);
+		return 1;
+	}
+
+	date::add_inmemory_file(africa, africa_size);
+	date::add_inmemory_file(antarctica, antarctica_size);
+	date::add_inmemory_file(asia, asia_size);
+	date::add_inmemory_file(australasia, australasia_size);
+	date::add_inmemory_file(backward, backward_size);
+	date::add_inmemory_file(etcetera, etcetera_size);
+	date::add_inmemory_file(europe, europe_size);
+	date::add_inmemory_file(leapseconds, leapseconds_size);
+	date::add_inmemory_file(northamerica, northamerica_size);
+	date::add_inmemory_file(southamerica, southamerica_size);
+	std::string _version((char *)version);
+	date::version_inmemory_file(_version);
+	date::xml_inmemory_file(windowsZones_xml, windowsZones_xml_size);
+
+	const date::tzdb& db = date::get_tzdb();
+	std::vector<unsigned char> image = HSS_Time_Private::TzSnapshot::build(db);
+
+	FILE* out = fopen(argv[1], "w");
+	if (!out) {
+		fprintf(stderr, "%s: unable to open %s\n", argv[0], argv[1]);
+		return 1;
+	}
+	fprintf(out, "// generated by WTimeTzSnapshot from tzdb %s, %d zones, do not edit\n\n", db.version.c_str(), (int)db.zones.size());
+	fprintf(out, "alignas(8) extern const unsigned char tzsnapshot_bin[] = {");
+	for (std::size_t i = 0; i < image.size(); i++)
+		fprintf(out, "%s0x%02x,", (i % 16) ? " " : "\n\t", image[i]);
+	fprintf(out, "\n};\n\nextern const unsigned int tzsnapshot_bin_size = %u;\n", (unsigned int)image.size());
+	fclose(out);
+	return 0;
+}
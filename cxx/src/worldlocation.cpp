@@ -20,10 +20,12 @@
 #include "times_internal.h"
 #include "worldlocation.h"
 #include "SunriseSunsetCalc.h"
+#include "SolarPosition.h"
 #include "str_printf.h"
 
 #include <cmath>
 #include <vector>
+#include <algorithm>
 #include <boost/algorithm/string/predicate.hpp>
 #include "boost_bimap.h"
 
@@ -568,6 +570,7 @@ void WorldLocation::SetTimeZoneOffset(const TimeZoneInfo* timezone)
 			_endDST = WTimeSpan(366, 0, 0, 0);
 	}
 	_timezoneInfo = timezone;
+	_generation++;
 }
 
 
@@ -833,12 +836,32 @@ const TimeZoneInfo* WorldLocation::GetStandardTimeZone(const TimeZoneInfo* info)
 }
 
 
+const TimeZoneOffset& TimeZoneTransitions::find(INTNM::uint64_t time) const
+{
+	constexpr INTNM::uint64_t cycle = 146097LL * 24LL * 60LL * 60LL * 1000000LL;	// the Gregorian calendar, and so the tzdb's rules, repeat every 400 years
+	if (time >= m_end)
+		time -= ((time - (m_end - cycle)) / cycle) * cycle;
+	const INTNM::uint64_t* it = std::upper_bound(m_times, m_times + m_count, time);
+	return m_offsets[(it - m_times) - 1];
+}
+
+
+// start opening the timezone databases once something is going to need them, not while the library loads where it would
+// race the tz statics
+static inline void auto_prewarm() {
+#ifdef WTIME_AUTO_PREWARM
+	TimezoneMapper::prewarm();
+#endif
+}
+
+
 WorldLocation::WorldLocation()
-	: _timezoneInfo(nullptr)
+	: _timezoneInfo(nullptr), _generation(0)
 #ifdef HSS_USE_CACHING
-	, m_sunCache(4), m_solarCache(4)
+	, m_solarCache(4)
 #endif
 {
+	auto_prewarm();
 	_latitude = 1000.0;
 	_longitude = 1000.0;
 	__timezone = WTimeSpan(0);
@@ -849,9 +872,9 @@ WorldLocation::WorldLocation()
 
 
 WorldLocation::WorldLocation(const WorldLocation &wl)
-	: _timezoneInfo(nullptr)
+	: _timezoneInfo(nullptr), _generation(0), m_sunCache(wl.m_sunCache)
 #ifdef HSS_USE_CACHING
-	, m_sunCache(4), m_solarCache(4)
+	, m_solarCache(4)
 #endif
 {
 	*this = wl;
@@ -859,11 +882,12 @@ WorldLocation::WorldLocation(const WorldLocation &wl)
 
 
 WorldLocation::WorldLocation(double latitude, double longitude, bool guessTimezone)
-	: _timezoneInfo(nullptr)
+	: _timezoneInfo(nullptr), _generation(0)
 #ifdef HSS_USE_CACHING
-	, m_sunCache(4), m_solarCache(4)
+	, m_solarCache(4)
 #endif
 {
+	auto_prewarm();
 	_latitude = DEGREE_TO_RADIAN(latitude);
 	_longitude = DEGREE_TO_RADIAN(longitude);
 	if (guessTimezone)
@@ -892,9 +916,10 @@ WorldLocation &WorldLocation::operator=(const WorldLocation &wl) {
 		_startDST = wl._startDST;
 		_endDST = wl._endDST;
 		_amtDST = wl._amtDST;
+		_generation++;
 
-#ifdef HSS_USE_CACHING
 		m_sunCache.Clear();
+#ifdef HSS_USE_CACHING
 		m_solarCache.Clear();
 #endif
 
@@ -996,6 +1021,7 @@ CArchive& HSS_Time::operator>>(CArchive& is, WorldLocation &wl) {
 				is >> ts; wl._amtDST = WTimeSpan(ts);
 			} else if (loader.svalue[1] >= 3)
 				is >> wl._startDST >> wl._endDST >> wl._amtDST;
+			wl._generation++;
 
 			// try to guess what the timezone ID is
 			const ::TimeZoneInfo* tz;
@@ -1013,6 +1039,7 @@ CArchive& HSS_Time::operator>>(CArchive& is, WorldLocation &wl) {
 		is >> loader.svalue[2] >> loader.svalue[3];
 		wl._latitude = loader.dvalue;
 		is >> wl._longitude >> wl.__timezone;
+		wl._generation++;
 	}
 	return is;
 }
@@ -1040,83 +1067,23 @@ CArchive& HSS_Time::operator<<(CArchive& os, const WorldLocation &wl) {
 
 
 INTNM::int16_t WorldLocation::m_sun_rise_set(const WTime &daytime, WTime *Rise, WTime *Set, WTime *Noon) const {
-
-#ifdef HSS_USE_CACHING
-	struct sun_key sk;
-	sk.m_sun_cache_lat = _latitude;
-	sk.m_sun_cache_long = _longitude;
-	sk.m_sun_cache_tm = daytime.GetTime(0);
-	struct sun_val sv;
-	if (m_sunCache.Retrieve(&sk, &sv)) {
-		*Rise = WTime(sv.m_sun_cache_rise, Rise->GetTimeManager());
-		*Set = WTime(sv.m_sun_cache_set, Set->GetTimeManager());
-		*Noon = WTime(sv.m_sun_cache_noon, Noon->GetTimeManager());
-		return sv.m_success;
-	}
-#endif
-
-	INTNM::int32_t	day = daytime.GetDay(WTIME_FORMAT_AS_SOLAR),
-					year = daytime.GetYear(WTIME_FORMAT_AS_SOLAR),
-					month = daytime.GetMonth(WTIME_FORMAT_AS_SOLAR);
-
-	CSunriseSunsetCalc calculator;
-	RISESET_IN_STRUCT sInput;
-	sInput.Latitude = RADIAN_TO_DEGREE(_latitude);
-	sInput.Longitude = -RADIAN_TO_DEGREE(_longitude);
-	sInput.timezone = 0;
-	sInput.DaytimeSaving = false;
-	sInput.year = year;
-	sInput.month = month;
-	sInput.day = day;
-	RISESET_OUT_STRUCT sOut;
-	INTNM::int16_t success = calculator.calcSun(sInput,&sOut);
-
-	WTime riseTime(0ULL, Rise->GetTimeManager()),
-		  setTime(0ULL, Set->GetTimeManager()),
-		  noonTime(0ULL, Noon->GetTimeManager());
-	if (!(success & NO_SUNRISE))
-		riseTime = WTime(sOut.YearRise,sOut.MonthRise,sOut.DayRise,sOut.HourRise,sOut.MinRise,(INTNM::int32_t)sOut.SecRise,Rise->GetTimeManager());
-	*Rise = riseTime;
-	if (!(success & NO_SUNSET))
-		setTime = WTime(sOut.YearSet,sOut.MonthSet,sOut.DaySet,sOut.HourSet,sOut.MinSet,(INTNM::int32_t)sOut.SecSet,Set->GetTimeManager());
-	*Set = setTime;
-	noonTime = WTime(sInput.year,sInput.month,sInput.day, sOut.SolarNoonHour, sOut.SolarNoonMin, (INTNM::int32_t)sOut.SolarNoonSec,Noon->GetTimeManager());
-	*Noon = noonTime;
-		
-#ifdef HSS_USE_CACHING
-	sk.m_sun_cache_tm = daytime.GetTime(0);
-	sk.m_sun_cache_lat = _latitude;
-	sk.m_sun_cache_long = _longitude;
-	sv.m_sun_cache_rise = Rise->GetTotalSeconds();
-	sv.m_sun_cache_set = Set->GetTotalSeconds();
-	sv.m_sun_cache_noon = Noon->GetTotalSeconds();
-	sv.m_success = success;
-	m_sunCache.Store(&sk, &sv);
-#endif
-
-	return success;
+	return m_sun_rise_set(_latitude, _longitude, daytime, Rise, Set, Noon);
 }
 
 
 INTNM::int16_t WorldLocation::m_sun_rise_set(double latitude, double longitude, const WTime& daytime, WTime* Rise, WTime* Set, WTime* Noon) const {
-
-#ifdef HSS_USE_CACHING
-	struct sun_key sk;
-	sk.m_sun_cache_lat = latitude;
-	sk.m_sun_cache_long = longitude;
-	sk.m_sun_cache_tm = daytime.GetTime(0);
-	struct sun_val sv;
-	if (m_sunCache.Retrieve(&sk, &sv)) {
-		*Rise = WTime(sv.m_sun_cache_rise, Rise->GetTimeManager());
-		*Set = WTime(sv.m_sun_cache_set, Set->GetTimeManager());
-		*Noon = WTime(sv.m_sun_cache_noon, Noon->GetTimeManager());
+	// the results only depend on the solar day, not on the time of day
+	const INTNM::int64_t solarDay = (INTNM::int64_t)daytime.GetTime(WTIME_FORMAT_AS_SOLAR) / (24LL * 60LL * 60LL);
+	const SunCache::Key sk(solarDay, latitude, longitude);
+	SunCache::Value sv;
+	if (m_sunCache.Retrieve(sk, &sv)) {
+		*Rise = WTime(sv.m_rise, Rise->GetTimeManager());
+		*Set = WTime(sv.m_set, Set->GetTimeManager());
+		*Noon = WTime(sv.m_noon, Noon->GetTimeManager());
 		return sv.m_success;
 	}
-#endif
 
-	INTNM::int32_t	day = daytime.GetDay(WTIME_FORMAT_AS_SOLAR),
-		year = daytime.GetYear(WTIME_FORMAT_AS_SOLAR),
-		month = daytime.GetMonth(WTIME_FORMAT_AS_SOLAR);
+	const CivilCalendar::CivilDate date = CivilCalendar::CivilFromDays(solarDay);
 
 	CSunriseSunsetCalc calculator;
 	RISESET_IN_STRUCT sInput;
@@ -1124,9 +1091,9 @@ INTNM::int16_t WorldLocation::m_sun_rise_set(double latitude, double longitude,
 	sInput.Longitude = -RADIAN_TO_DEGREE(longitude);
 	sInput.timezone = 0;
 	sInput.DaytimeSaving = false;
-	sInput.year = year;
-	sInput.month = month;
-	sInput.day = day;
+	sInput.year = date.m_year;
+	sInput.month = date.m_month;
+	sInput.day = date.m_day;
 	RISESET_OUT_STRUCT sOut;
 	INTNM::int16_t success = calculator.calcSun(sInput, &sOut);
 
@@ -1142,21 +1109,54 @@ INTNM::int16_t WorldLocation::m_sun_rise_set(double latitude, double longitude,
 	noonTime = WTime(sInput.year, sInput.month, sInput.day, sOut.SolarNoonHour, sOut.SolarNoonMin, (INTNM::int32_t)sOut.SolarNoonSec, Noon->GetTimeManager());
 	*Noon = noonTime;
 
-#ifdef HSS_USE_CACHING
-	sk.m_sun_cache_tm = daytime.GetTime(0);
-	sk.m_sun_cache_lat = latitude;
-	sk.m_sun_cache_long = longitude;
-	sv.m_sun_cache_rise = Rise->GetTotalSeconds();
-	sv.m_sun_cache_set = Set->GetTotalSeconds();
-	sv.m_sun_cache_noon = Noon->GetTotalSeconds();
+	sv.m_rise = Rise->GetTotalSeconds();
+	sv.m_set = Set->GetTotalSeconds();
+	sv.m_noon = Noon->GetTotalSeconds();
 	sv.m_success = success;
-	m_sunCache.Store(&sk, &sv);
-#endif
+	m_sunCache.Store(sk, sv);
 
 	return success;
 }
 
 
+void WorldLocation::m_sun_rise_set(const double* latitude, const double* longitude, std::size_t count, const WTime& local_day,
+		INTNM::uint64_t* rise, INTNM::uint64_t* set, INTNM::uint64_t* noon, INTNM::int16_t* success) const {
+	constexpr INTNM::int64_t DAY_MICROSECONDS = 24LL * 60LL * 60LL * 1000000LL;
+	constexpr std::size_t CHUNK = 1024;
+	const INTNM::int64_t solarDay = (INTNM::int64_t)local_day.GetTime(WTIME_FORMAT_AS_SOLAR) / (24LL * 60LL * 60LL);
+	const INTNM::int64_t midnight = solarDay * DAY_MICROSECONDS;
+	const CivilCalendar::CivilDate date = CivilCalendar::CivilFromDays(solarDay);
+	const std::ptrdiff_t chunks = (std::ptrdiff_t)((count + CHUNK - 1) / CHUNK);
+
+	#pragma omp parallel for schedule(dynamic)
+	for (std::ptrdiff_t chunk = 0; chunk < chunks; chunk++) {
+		const std::size_t first = chunk * CHUNK, length = std::min(CHUNK, count - first);
+		double lat[CHUNK], lon[CHUNK], riseUTC[CHUNK], setUTC[CHUNK], noonUTC[CHUNK];
+		for (std::size_t i = 0; i < length; i++) {
+			lat[i] = RADIAN_TO_DEGREE(latitude[first + i]);
+			lon[i] = -RADIAN_TO_DEGREE(longitude[first + i]);
+		}
+
+		CSunriseSunsetCalc calculator;
+		calculator.calcSunBatch(date.m_year, date.m_month, date.m_day, lat, lon, length, riseUTC, setUTC, noonUTC, success + first);
+
+		for (std::size_t i = 0; i < length; i++) {
+			const INTNM::int64_t riseMask = (INTNM::int64_t)(success[first + i] & NO_SUNRISE) - 1;	// all ones when there is a sunrise
+			const INTNM::int64_t setMask = (INTNM::int64_t)((success[first + i] & NO_SUNSET) >> 1) - 1;
+			rise[first + i] = (INTNM::uint64_t)((midnight + std::llround(riseUTC[i] * 60000000.0)) & riseMask);
+			set[first + i] = (INTNM::uint64_t)((midnight + std::llround(setUTC[i] * 60000000.0)) & setMask);
+			noon[first + i] = (INTNM::uint64_t)(midnight + std::llround(noonUTC[i] * 60000000.0));
+		}
+	}
+}
+
+
+void WorldLocation::m_sun_position(const WTime& time, double* elevation, double* azimuth) const {
+	SolarPosition position(_latitude, _longitude);
+	position.Position(time.GetTotalMicroSeconds(), elevation, azimuth);
+}
+
+
 WorldLocation WorldLocation::FromLatLon(const double lat, const double lon, INTNM::int16_t set, bool* valid) {
 	const ::TimeZoneInfo* info = TimezoneMapper::getTz(RADIAN_TO_DEGREE(lat), RADIAN_TO_DEGREE(lon), set, valid);
 	WorldLocation wld;
@@ -1174,3 +1174,47 @@ const ::TimeZoneInfo* WorldLocation::TimeZoneFromLatLon(const double lat, const
 	return TimezoneMapper::getTz(RADIAN_TO_DEGREE(lat), RADIAN_TO_DEGREE(lon), set, valid);
 }
 
+
+void WorldLocation::TimeZoneFromLatLon(const double* lat, const double* lon, std::size_t count, INTNM::int16_t set, const TimeZoneInfo** timezones, bool* valid) {
+	std::vector<double> latd(count), lond(count);
+	for (std::size_t i = 0; i < count; i++) {
+		latd[i] = RADIAN_TO_DEGREE(lat[i]);
+		lond[i] = RADIAN_TO_DEGREE(lon[i]);
+	}
+	TimezoneMapper::getTzBatch(latd.data(), lond.data(), count, set, timezones, valid);
+}
+
+
+void WorldLocation::SetTimeZoneTileResolution(double degrees) {
+	TimezoneMapper::setTileResolution(degrees);
+}
+
+
+double WorldLocation::GetTimeZoneTileResolution() {
+	return TimezoneMapper::tileResolution();
+}
+
+
+void WorldLocation::GetTimeZoneTileStatistics(std::uint64_t* hits, std::uint64_t* misses) {
+	TimezoneMapper::tileStatistics(hits, misses);
+}
+
+
+void WorldLocation::ClearTimeZoneTileCache() {
+	TimezoneMapper::clearTileCache();
+}
+
+
+void WorldLocation::PrewarmTimeZones() {
+	TimezoneMapper::prewarm();
+}
+
+
+void WorldLocation::FinishPrewarmTimeZones() {
+	TimezoneMapper::finishPrewarm();
+}
+
+
+bool WorldLocation::SetTimeZoneDatabase(const std::string& path) {
+	return TimezoneMapper::setDatabasePath(path);
+}
@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "WTime.h"
+
+using namespace HSS_Time;
+
+
+// Counts every C++ heap allocation made while counting is set, including those made inside the WTime library when it
+// binds to this operator new (ELF platforms, not separate MSVC runtimes). ZoneDetect is C and allocates its results
+// with malloc, so with glibc the malloc family is replaced as well and every block taken and released is counted too.
+namespace
+{
+std::atomic<bool> counting(false);
+std::atomic<std::size_t> allocations(0);
+std::atomic<std::size_t> mallocs(0), frees(0);
+}
+
+#if defined(__GLIBC__)
+#define WTIME_COUNT_MALLOC 1
+
+extern "C" void* __libc_malloc(std::size_t size);
+extern "C" void* __libc_calloc(std::size_t count, std::size_t size);
+extern "C" void* __libc_realloc(void* p, std::size_t size);
+extern "C" void __libc_free(void* p);
+
+extern "C" void* malloc(std::size_t size)
+{
+    if (counting.load(std::memory_order_relaxed))
+        mallocs.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(std::size_t count, std::size_t size)
+{
+    if (counting.load(std::memory_order_relaxed))
+        mallocs.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+// growing or shrinking a block neither takes a new one nor releases one
+extern "C" void* realloc(void* p, std::size_t size)
+{
+    if (counting.load(std::memory_order_relaxed))
+    {
+        if (!p)
+            mallocs.fetch_add(1, std::memory_order_relaxed);
+        else if (!size)
+            frees.fetch_add(1, std::memory_order_relaxed);
+    }
+    return __libc_realloc(p, size);
+}
+
+extern "C" void free(void* p)
+{
+    if ((p) && (counting.load(std::memory_order_relaxed)))
+        frees.fetch_add(1, std::memory_order_relaxed);
+    __libc_free(p);
+}
+#endif
+
+void* operator new(std::size_t size)
+{
+    if (counting.load(std::memory_order_relaxed))
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+
+namespace
+{
+constexpr double degree = 0.017453292519943295;
+
+// operator new allocates with malloc, so mallocs and frees include the C++ allocations
+struct Counts
+{
+    std::size_t allocations;
+    std::size_t mallocs;
+    std::size_t frees;
+};
+
+Counts countLookups(double lat, double lon, int iterations)
+{
+    bool valid;
+    WorldLocation::TimeZoneFromLatLon(lat * degree, lon * degree, 0, &valid);
+
+    allocations = 0;
+    mallocs = 0;
+    frees = 0;
+    counting = true;
+    for (int i = 0; i < iterations; i++)
+        WorldLocation::TimeZoneFromLatLon(lat * degree, (lon + (i % 10) * 0.0001) * degree, 0, &valid);
+    counting = false;
+    return { allocations.load(), mallocs.load(), frees.load() };
+}
+
+TEST(AllocationTest, TileCacheLookup)
+{
+    Counts counts = countLookups(53.505, -113.495, 1000);
+    EXPECT_EQ(0U, counts.allocations);
+#if WTIME_COUNT_MALLOC
+    EXPECT_EQ(0U, counts.mallocs);
+    EXPECT_EQ(0U, counts.frees);
+#endif
+}
+
+TEST(AllocationTest, UncachedLookup)
+{
+    double resolution = WorldLocation::GetTimeZoneTileResolution();
+    WorldLocation::SetTimeZoneTileResolution(0.0);
+
+    // the WTime side of a miss allocates nothing, but ZDLookup mallocs its results (and their strings) on every call
+    // and has no way to reuse them, so the most that can be said is that ZDFreeResults hands all of it back
+    Counts counts = countLookups(45.5, -73.6, 1000);
+    EXPECT_EQ(0U, counts.allocations);
+#if WTIME_COUNT_MALLOC
+    EXPECT_GE(counts.mallocs, 1000U);
+    EXPECT_EQ(counts.mallocs, counts.frees);
+#endif
+
+    WorldLocation::SetTimeZoneTileResolution(resolution);
+}
+}
@@ -0,0 +1,122 @@
+/**
+ * benchmark.cpp
+ *
+ * Copyright 2016-2023 Heartland Software Solutions Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the license at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the LIcense is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <utility>
+
+
+namespace HSS_Time_Benchmark
+{
+	static std::vector<std::pair<const char*, BenchmarkFunction>>& benchmarks()
+	{
+		static std::vector<std::pair<const char*, BenchmarkFunction>> list;
+		return list;
+	}
+
+	static const char* current = "";
+	static const char* executable = "";
+
+
+	Registration::Registration(const char* name, BenchmarkFunction function)
+	{
+		benchmarks().emplace_back(name, function);
+	}
+
+
+	void report(const std::string& label, double value, const char* units)
+	{
+		printf("%-32s %-40s %14.3f %s\n", current, label.c_str(), value, units);
+		fflush(stdout);
+	}
+
+
+	void reportMemory(const std::string& label)
+	{
+		FILE* status = fopen("/proc/self/status", "r");
+		if (!status)
+			return;
+		char line[256];
+		while (fgets(line, sizeof(line), status))
+		{
+			for (const char* field : { "VmRSS:", "RssAnon:", "RssFile:" })
+			{
+				std::size_t length = strlen(field);
+				if (!strncmp(line, field, length))
+					report(label + " " + std::string(field, length - 1), strtod(line + length, nullptr), "kB");
+			}
+		}
+		fclose(status);
+	}
+
+
+#ifndef __GNUC__
+	void escape(const volatile void*)
+	{
+	}
+#endif
+
+
+	int runInProcess(const char* name, const char* variable, const char* value)
+	{
+#ifdef _WIN32
+		if (variable)
+			_putenv_s(variable, value);
+#else
+		if (variable)
+			setenv(variable, value, 1);
+#endif
+		std::string command = std::string("\"") + executable + "\" " + name;
+		int result = std::system(command.c_str());
+#ifdef _WIN32
+		if (variable)
+			_putenv_s(variable, "");
+#else
+		if (variable)
+			unsetenv(variable);
+#endif
+		return result;
+	}
+}
+
+
+// usage: WTimeBenchmark [filter], only benchmarks whose name contains filter are run
+int main(int argc, char* argv[])
+{
+	const char* filter = argc > 1 ? argv[1] : nullptr;
+	HSS_Time_Benchmark::executable = argv[0];
+
+	for (auto& benchmark : HSS_Time_Benchmark::benchmarks())
+	{
+		if (benchmark.first[0] == '_')
+		{
+			if ((!filter) || (strcmp(benchmark.first, filter)))
+				continue;
+		}
+		else if (filter && !strstr(benchmark.first, filter))
+			continue;
+		HSS_Time_Benchmark::current = benchmark.first;
+		benchmark.second();
+	}
+	return 0;
+}
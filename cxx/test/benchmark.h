@@ -0,0 +1,105 @@
+/**
+ * benchmark.h
+ *
+ * Copyright 2016-2023 Heartland Software Solutions Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the license at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the LIcense is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+namespace HSS_Time_Benchmark
+{
+	typedef void (*BenchmarkFunction)();
+
+	/**
+	 * Registers a benchmark with the runner in benchmark.cpp, use WTIME_BENCHMARK rather than this directly.
+	 */
+	struct Registration
+	{
+		Registration(const char* name, BenchmarkFunction function);
+	};
+
+	class Stopwatch
+	{
+	public:
+		Stopwatch() : m_start(std::chrono::steady_clock::now()) { }
+
+		void restart()			{ m_start = std::chrono::steady_clock::now(); }
+		double seconds() const	{ return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count(); }
+
+	private:
+		std::chrono::steady_clock::time_point m_start;
+	};
+
+	/**
+	 * Print a single result line for the benchmark that is currently running.
+	 * @param label What was measured.
+	 * @param value The measurement.
+	 * @param units The units of value.
+	 */
+	void report(const std::string& label, double value, const char* units);
+
+	/**
+	 * Report the process's resident memory (VmRSS, RssAnon and RssFile from /proc/self/status), nothing is reported where
+	 * that isn't available.
+	 * @param label Prefixed to each measurement.
+	 */
+	void reportMemory(const std::string& label);
+
+	/**
+	 * Run a benchmark in a fresh copy of this process, for measuring things that only happen once per process. Names
+	 * starting with an underscore are only run when asked for by their full name, which makes them suitable for this.
+	 * @param name The benchmark to run.
+	 * @param variable If not null, an environment variable to set for the child.
+	 * @param value The value of variable.
+	 * @return The child's exit code.
+	 */
+	int runInProcess(const char* name, const char* variable = nullptr, const char* value = nullptr);
+
+#ifndef __GNUC__
+	/**
+	 * Does nothing, but it's defined in benchmark.cpp so the compiler can't see that at the call.
+	 */
+	void escape(const volatile void* pointer);
+#endif
+
+	/**
+	 * Stop the optimizer from discarding work whose result is otherwise unused. The whole value counts as read, and
+	 * nothing is stored anywhere.
+	 */
+	template<typename T>
+	inline void keep(const T& value)
+	{
+#ifdef __GNUC__
+		asm volatile("" : : "g"(&value) : "memory");
+#else
+		escape(&value);
+		_ReadWriteBarrier();
+#endif
+	}
+}
+
+#define WTIME_BENCHMARK(name)																\
+	static void name();																		\
+	static HSS_Time_Benchmark::Registration name##_registration(#name, &name);				\
+	static void name()
@@ -0,0 +1,185 @@
+#include <gtest/gtest.h>
+
+#include "WTime.h"
+#include "testLocations.h"
+#include "julianReference.h"
+
+#include <vector>
+
+using namespace HSS_Time;
+using namespace HSS_Time_Test;
+using namespace HSS_Time_Reference;
+
+
+namespace
+{
+TEST(WTimeCalendarTest, DecomposeMatchesGetters)
+{
+    WorldLocation location = mountainLocation();
+    WTimeManager manager(location);
+
+    // every 7 hours and a few microseconds for a couple of centuries, which lands on every time of day and both sides of DST
+    WTime t(1900, 1, 1, 0, 0, 0, 17, &manager);
+    WTimeSpan step(0, 7, 0, 0, 123457);
+    for (int i = 0; i < 250000; i++, t += step)
+    {
+        for (INTNM::uint32_t flags : { 0U, (INTNM::uint32_t)WTIME_FORMAT_AS_LOCAL, (INTNM::uint32_t)(WTIME_FORMAT_AS_LOCAL | WTIME_FORMAT_WITHDST) })
+        {
+            WTimeFields fields = t.Decompose(flags);
+            ASSERT_EQ(t.GetYear(flags), fields.m_year);
+            ASSERT_EQ(t.GetMonth(flags), fields.m_month);
+            ASSERT_EQ(t.GetDay(flags), fields.m_day);
+            ASSERT_EQ(t.GetHour(flags), fields.m_hour);
+            ASSERT_EQ(t.GetMinute(flags), fields.m_minute);
+            ASSERT_EQ(t.GetSecond(flags), fields.m_second);
+            ASSERT_EQ(t.GetMicroSeconds(flags), fields.m_microSeconds);
+            ASSERT_EQ(t.GetDayOfWeek(flags), fields.m_dayOfWeek);
+
+            WTime year(fields.m_year, 1, 1, 0, 0, 0, &manager);
+            ASSERT_EQ((t.GetTime(flags) - year.GetTotalSeconds()) / (24 * 60 * 60) + 1, (INTNM::uint64_t)fields.m_dayOfYear);
+            ASSERT_EQ(t.GetTime(flags) - year.GetTotalSeconds(), t.GetSecondsIntoYear(flags));
+        }
+    }
+}
+
+TEST(WTimeCalendarTest, DecomposeUnsetTime)
+{
+    WTime t((INTNM::uint64_t)-1, nullptr, false);
+    WTimeFields fields = t.Decompose(0);
+    EXPECT_EQ(-1, fields.m_year);
+    EXPECT_EQ(-1, fields.m_dayOfYear);
+}
+
+TEST(WTimeCalendarTest, KernelsMatchJulianArithmetic)
+{
+    // every day from 1600 through 2400
+    const std::int64_t last = CivilCalendar::DaysFromCivil(2400, 12, 31);
+    for (std::int64_t days = 0; days <= last; days++)
+    {
+        std::int32_t year, month, day;
+        julianCivilFromDays((std::uint64_t)days, &year, &month, &day);
+
+        CivilCalendar::CivilDate date = CivilCalendar::CivilFromDays(days);
+        ASSERT_EQ(year, date.m_year) << days;
+        ASSERT_EQ(month, date.m_month) << days;
+        ASSERT_EQ(day, date.m_day) << days;
+        ASSERT_EQ(julianDaysFromCivil(year, month, day), (std::uint64_t)CivilCalendar::DaysFromCivil(year, month, day)) << days;
+        ASSERT_EQ(julianDaysFromCivil(year, 1, 1), (std::uint64_t)CivilCalendar::YearStart(year)) << days;
+        ASSERT_EQ((std::int32_t)(days - julianDaysFromCivil(year, 1, 1)) + 1, CivilCalendar::DayOfYear(year, month, day)) << days;
+        ASSERT_EQ(CivilCalendar::IsLeapYear(year), WTimeManager::isLeapYear((INTNM::int16_t)year)) << days;
+
+        WTime t(year, month, day, 12, 0, 0, nullptr);
+        ASSERT_EQ((std::uint64_t)days * 24 * 60 * 60 + 12 * 60 * 60, t.GetTotalSeconds()) << days;
+        ASSERT_EQ(CivilCalendar::DayOfWeek(days), t.GetDayOfWeek(0)) << days;
+    }
+}
+
+TEST(WTimeCalendarTest, KernelsRollOver)
+{
+    EXPECT_EQ(CivilCalendar::DaysFromCivil(2001, 1, 1), CivilCalendar::DaysFromCivil(2000, 13, 1));
+    EXPECT_EQ(CivilCalendar::DaysFromCivil(1999, 12, 1), CivilCalendar::DaysFromCivil(2000, 0, 1));
+    EXPECT_EQ(CivilCalendar::DaysFromCivil(2000, 3, 1), CivilCalendar::DaysFromCivil(2000, 2, 30));
+    EXPECT_EQ(CivilCalendar::DaysFromCivil(2000, 1, 1) - 1, CivilCalendar::DaysFromCivil(2000, 1, 0));
+
+    constexpr CivilCalendar::CivilDate date = CivilCalendar::CivilFromDays(CivilCalendar::DaysFromCivil(2024, 2, 29) + 1);
+    static_assert(date.m_month == 3 && date.m_day == 1, "CivilFromDays should work at compile time");
+}
+
+// the DST test adjusted_tm_math made before WTimeManager cached it, on seconds into the local standard year
+static bool legacyDST(const WorldLocation& location, const WTime& t)
+{
+    WTime local(t.GetTotalMicroSeconds() + location.m_timezone().GetTotalMicroSeconds(), nullptr, false);
+    INTNM::uint64_t secs = local.GetSecondsIntoYear(0);
+    if (location.m_startDST() < location.m_endDST())
+        return ((INTNM::uint64_t)location.m_startDST().GetTotalSeconds() <= secs) && (secs < (INTNM::uint64_t)location.m_endDST().GetTotalSeconds());
+    return ((INTNM::uint64_t)location.m_startDST().GetTotalSeconds() < secs) || (secs <= (INTNM::uint64_t)location.m_endDST().GetTotalSeconds());
+}
+
+static void expectLegacyDST(const WorldLocation& location, const WTimeManager& manager)
+{
+    // every 17 minutes and a few microseconds, crossing the DST edges at different offsets each year
+    WTime t(1998, 12, 1, 0, 0, 0, &manager);
+    WTimeSpan step(0, 0, 17, 0, 999);
+    for (int i = 0; i < 100000; i++, t += step)
+    {
+        INTNM::uint64_t expected = t.GetTotalMicroSeconds() + location.m_timezone().GetTotalMicroSeconds();
+        if (legacyDST(location, t))
+            expected += location.m_amtDST().GetTotalMicroSeconds();
+        ASSERT_EQ(expected / 1000000, t.GetTime(WTIME_FORMAT_AS_LOCAL | WTIME_FORMAT_WITHDST)) << i;
+    }
+}
+
+TEST(WTimeCalendarTest, DSTCacheMatchesUncached)
+{
+    WorldLocation location = mountainLocation();
+    WTimeManager manager(location);
+    expectLegacyDST(location, manager);
+
+    // southern hemisphere, DST wraps past the end of the year
+    location.m_timezone(WTimeSpan(0, 10, 0, 0));
+    location.m_startDST(WTimeSpan(276, 2, 0, 0));
+    location.m_endDST(WTimeSpan(95, 3, 0, 0, 500000));
+    expectLegacyDST(location, manager);
+
+    // DST all year, the end is past the last day of any year
+    location.m_startDST(WTimeSpan(0));
+    location.m_endDST(WTimeSpan(366, 0, 0, 0));
+    expectLegacyDST(location, manager);
+}
+
+TEST(WTimeCalendarTest, DSTCacheFollowsSetters)
+{
+    WorldLocation location = mountainLocation();
+    WTimeManager manager(location);
+
+    const INTNM::uint32_t flags = WTIME_FORMAT_AS_LOCAL | WTIME_FORMAT_WITHDST;
+    WTime summer(2023, 7, 1, 12, 0, 0, &manager);
+    EXPECT_EQ(6, summer.GetHour(flags));
+    location.m_endDST(WTimeSpan(69, 9, 0, 0));		// DST off
+    EXPECT_EQ(5, summer.GetHour(flags));
+    location.m_endDST(WTimeSpan(150, 0, 0, 0));		// ends before July
+    EXPECT_EQ(5, summer.GetHour(flags));
+    location.m_endDST(WTimeSpan(307, 8, 0, 0));
+    EXPECT_EQ(6, summer.GetHour(flags));
+    location.m_timezone(WTimeSpan(0, -6, 0, 0));
+    EXPECT_EQ(7, summer.GetHour(flags));
+
+    WorldLocation other;
+    location = other;
+    EXPECT_EQ(12, summer.GetHour(flags));
+}
+
+TEST(WTimeCalendarTest, BatchDecomposeMatchesDecompose)
+{
+    WorldLocation location = mountainLocation();
+    WTimeManager manager(location);
+
+    // not a multiple of the block size, with an unset time in the middle and one in 1600 before the timezone moves it back
+    const std::size_t count = 5000;
+    std::vector<INTNM::uint64_t> times(count);
+    WTime t(1890, 3, 1, 5, 0, 0, &manager);
+    WTimeSpan step(3, 7, 11, 13, 17);
+    for (std::size_t i = 0; i < count; i++, t += step)
+        times[i] = t.GetTotalMicroSeconds();
+    times[1234] = (INTNM::uint64_t)-1;
+    times[4321] = 12 * 60 * 60 * 1000000ULL;
+
+    std::vector<INTNM::int32_t> year(count), month(count), day(count), hour(count), minute(count), second(count), dayOfYear(count);
+    WTimeColumns columns{ year.data(), month.data(), day.data(), hour.data(), minute.data(), second.data(), dayOfYear.data() };
+    for (INTNM::uint32_t flags : { 0U, (INTNM::uint32_t)WTIME_FORMAT_AS_LOCAL, (INTNM::uint32_t)(WTIME_FORMAT_AS_LOCAL | WTIME_FORMAT_WITHDST) })
+    {
+        WTime::Decompose(times.data(), count, &manager, flags, columns);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            WTimeFields fields = WTime(times[i], &manager, false).Decompose(flags);
+            ASSERT_EQ(fields.m_year, year[i]) << i;
+            ASSERT_EQ(fields.m_month, month[i]) << i;
+            ASSERT_EQ(fields.m_day, day[i]) << i;
+            ASSERT_EQ(fields.m_hour, hour[i]) << i;
+            ASSERT_EQ(fields.m_minute, minute[i]) << i;
+            ASSERT_EQ(fields.m_second, second[i]) << i;
+            ASSERT_EQ(fields.m_dayOfYear, dayOfYear[i]) << i;
+        }
+    }
+}
+}
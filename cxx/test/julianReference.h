@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+
+// WTime's calendar arithmetic as it was before CivilCalendar, kept as the reference the kernels are tested and timed against
+namespace HSS_Time_Reference
+{
+	// the date part of the original WTime::construct_time_t, days since January 1, 1600
+	inline std::uint64_t julianDaysFromCivil(std::int32_t year, std::int32_t month, std::int32_t day)
+	{
+		if (month <= 2)
+		{
+			year -= 1;
+			month += 12;
+		}
+		std::int32_t A = year / 100LL;
+		std::int32_t B = 2LL - A + A / 4;
+		std::uint64_t days = floor(365.25 * (year + 4716)) + floor(30.6001 * (month + 1)) + (day + 1) + B - 1524.5;
+		return days - 2305448;
+	}
+
+	// the original WTime::GetYear/GetMonth/GetDay
+	inline void julianCivilFromDays(std::uint64_t days, std::int32_t* year, std::int32_t* month, std::int32_t* day)
+	{
+		std::int64_t z = days + 2305448;
+		std::int64_t a = z + 32044;
+		std::int64_t b = (4 * a + 3) / 146097;
+		std::int64_t c = a - (b * 146097) / 4;
+		std::int64_t d = (4 * c + 3) / 1461;
+		std::int64_t e = c - (1461 * d) / 4;
+		std::int64_t m = (5 * e + 2) / 153;
+		*day = (std::int32_t)(e - (153 * m + 2) / 5 + 1);
+		*month = (std::int32_t)(m + 3 - 12 * (m / 10));
+		*year = (std::int32_t)(b * 100 + d - 4800 + m / 10);
+	}
+}
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "WTime.h"
+#include "testLocations.h"
+
+using namespace HSS_Time;
+using namespace HSS_Time_Test;
+
+
+namespace
+{
+TEST(WTimeParseTest, ParseISO8601MatchesGeneralParser)
+{
+    WorldLocation location = mountainLocation();
+    WTimeManager manager(location);
+
+    std::vector<std::string> dates = {
+        "2018-10-22", "2018-01-20T12:31:00Z", "2018-01-20T12:31:00", "2018-01-20T12:31", "2018-07-04 23:59:59",
+        "2018-07-04T06:00:00-06:00", "2018-07-04T06:00:00+05:30", "2018-03-11T02:30:00-00:00", "2024-02-29T00:00:00+14:00",
+        "1600-01-01T12:00:00Z", "2899-12-31T23:59:59Z", "2900-01-01T00:00:00Z",
+        // left to the general parser
+        "2018-01-20T12:31:00.5Z", "2018-01-20T24:00:00", "2018-01-20T12:31:00+0530", "18-01-20", "2018-13-01", "2018-01-20T12:31:00Zx" };
+    WTime start(2018, 1, 1, 0, 0, 0, &manager);
+    for (int i = 0; i < 400; i++)
+        dates.push_back((start + WTimeSpan(i, i % 24, (i * 7) % 60, (i * 13) % 60)).ToString(WTIME_FORMAT_STRING_ISO8601));
+
+    for (const std::string& date : dates)
+    {
+        // strtok skips the leading delimiter so the general parser reads this the same way, but the fast path won't take it
+        WorldLocation fast_location, general_location;
+        WTime fast(2018, 6, 1, 0, 0, 0, &manager), general(fast);
+        bool fast_result = fast.ParseDateTime(date, WTIME_FORMAT_STRING_ISO8601, &fast_location);
+        bool general_result = general.ParseDateTime(" " + date, WTIME_FORMAT_STRING_ISO8601, &general_location);
+        EXPECT_EQ(general_result, fast_result) << date;
+        EXPECT_EQ(general.GetTotalMicroSeconds(), fast.GetTotalMicroSeconds()) << date;
+        EXPECT_EQ(general_location.m_timezone(), fast_location.m_timezone()) << date;
+        EXPECT_EQ(general_location.m_amtDST(), fast_location.m_amtDST()) << date;
+    }
+
+    // only the view is read, not whatever follows it
+    WTime time(&manager), whole(&manager);
+    ASSERT_TRUE(time.ParseDateTime(std::string_view("2018-07-04T06:00:00-06:00 trailing").substr(0, 25), WTIME_FORMAT_STRING_ISO8601));
+    ASSERT_TRUE(whole.ParseDateTime(std::string("2018-07-04T06:00:00-06:00"), WTIME_FORMAT_STRING_ISO8601));
+    EXPECT_EQ(whole, time);
+}
+
+TEST(WTimeParseTest, ParseDateTimesColumn)
+{
+    // no DST, the parser doesn't give back the times ToString writes while DST is in effect so there'd be no cadence
+    WorldLocation location;
+    location.m_timezone(WTimeSpan(0, -6, 0, 0));
+    WTimeManager manager(location);
+    const INTNM::uint32_t flags = WTIME_FORMAT_STRING_ISO8601;
+
+    // a CSV column of hourly observations, long enough to be split between threads
+    constexpr std::size_t count = 10000;
+    std::string csv;
+    std::vector<std::size_t> offsets;
+    WTime t(2020, 1, 1, 0, 0, 0, &manager);
+    for (std::size_t i = 0; i < count; i++, t += WTimeSpan(0, 1, 0, 0))
+    {
+        offsets.push_back(csv.size());
+        csv += t.ToString(flags);
+        csv += (i % 2) ? ",\r\n" : "\n";
+    }
+    offsets.push_back(csv.size());
+
+    std::vector<INTNM::uint64_t> times(count), failures((count + 63) / 64, ~0ULL);
+    WTimeParseResult result = WTime::ParseDateTimes(csv.data(), offsets.data(), count, &manager, flags, times.data(), failures.data());
+    EXPECT_EQ(0, result.m_failed);
+    EXPECT_EQ(WTimeSpan(0, 1, 0, 0).GetTotalMicroSeconds(), result.m_step);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        WTime expected(&manager);
+        expected.ParseDateTime(csv.substr(offsets[i], 25), flags);
+        ASSERT_EQ(expected.GetTotalMicroSeconds(), times[i]) << i;
+    }
+    for (INTNM::uint64_t word : failures)
+        EXPECT_EQ(0, word);
+
+    // a bad row is reported and there's no cadence any more
+    std::string bad(csv);
+    bad.replace(offsets[5000], 4, "xxxx");
+    result = WTime::ParseDateTimes(bad.data(), offsets.data(), count, &manager, flags, times.data(), failures.data());
+    EXPECT_EQ(1, result.m_failed);
+    EXPECT_EQ(0, result.m_step);
+    EXPECT_EQ((INTNM::uint64_t)-1, times[5000]);
+    EXPECT_EQ(1ULL << (5000 % 64), failures[5000 / 64]);
+    EXPECT_EQ(times[4999] + WTimeSpan(0, 2, 0, 0).GetTotalMicroSeconds(), times[5001]);
+
+    // as is one that breaks the step right on a boundary between chunks
+    std::string gap(csv);
+    gap.replace(offsets[4096], 25, WTime(2020, 1, 1, 0, 0, 0, &manager).ToString(flags));
+    result = WTime::ParseDateTimes(gap.data(), offsets.data(), count, &manager, flags, times.data());
+    EXPECT_EQ(0, result.m_failed);
+    EXPECT_EQ(0, result.m_step);
+}
+
+TEST(WTimeParseTest, ParseIntoUnsetTime)
+{
+    WorldLocation location = mountainLocation();
+    WTimeManager manager(location);
+
+    // parsing starts from the time being parsed into, for an unset one that's (uint64_t)-1 which the DST test has to cope with
+    for (const char* date : { "2018-01-20T12:31:00", "2018-07-04T06:00:00", "2018-07-04 23:59:59", "2018-10-22" })
+    {
+        WTime unset(&manager), set(2000, 1, 1, 0, 0, 0, &manager);
+        ASSERT_FALSE(unset.IsValid());
+        EXPECT_TRUE(unset.ParseDateTime(std::string(date), WTIME_FORMAT_STRING_ISO8601 | WTIME_FORMAT_AS_LOCAL | WTIME_FORMAT_WITHDST)) << date;
+        EXPECT_TRUE(set.ParseDateTime(std::string(date), WTIME_FORMAT_STRING_ISO8601 | WTIME_FORMAT_AS_LOCAL | WTIME_FORMAT_WITHDST)) << date;
+        EXPECT_EQ(set, unset) << date;
+    }
+}
+}
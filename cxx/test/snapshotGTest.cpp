@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "WTime.h"
+#include "CivilCalendar.h"
+#include "TimeZoneMapper.h"
+#include "TzSnapshot.h"
+
+using namespace HSS_Time;
+using namespace HSS_Time_Private;
+
+
+namespace
+{
+TEST(TzSnapshotTest, OpensEmbeddedImage)
+{
+    std::size_t size;
+    const void* image = TimezoneMapper::snapshotImage(&size);
+    TzSnapshot snapshot;
+    ASSERT_TRUE(snapshot.open(image, size));
+
+    const char* canonical = nullptr;
+    TimeZoneTransitions transitions;
+    EXPECT_TRUE(snapshot.find("America/Edmonton", &canonical, &transitions));
+    EXPECT_STREQ("America/Edmonton", canonical);
+    EXPECT_GT(transitions.m_count, 1U);
+    EXPECT_EQ(0U, transitions.m_times[0]);
+
+    // links resolve to their zone
+    EXPECT_TRUE(snapshot.find("Canada/Mountain", &canonical, nullptr));
+    EXPECT_STREQ("America/Edmonton", canonical);
+
+    EXPECT_FALSE(snapshot.find("Not/AZone", nullptr, nullptr));
+
+    // the table stops 400 years after Alberta's last rule change in 2007, find repeats it from there
+    const std::uint64_t year = 365ULL * 24 * 60 * 60 * 1000000;
+    EXPECT_LT(transitions.m_end, (std::uint64_t)(TzSnapshot::tableEnd() - TzSnapshot::tableStart()).count() * 1000000ULL);
+    EXPECT_GT(transitions.m_end, 806 * year);
+    EXPECT_EQ(transitions.find(2300 * year / 4).m_offset, transitions.find(2300 * year / 4 + 146097ULL * 24 * 60 * 60 * 1000000).m_offset);
+}
+
+TEST(TzSnapshotTest, RepeatingEnd)
+{
+    auto micros = [](std::int32_t year, std::int32_t month, std::int32_t day) {
+        return (std::uint64_t)CivilCalendar::DaysFromCivil(year, month, day) * 24 * 60 * 60 * 1000000;
+    };
+    const std::uint64_t horizon = (std::uint64_t)(TzSnapshot::tableEnd() - TzSnapshot::tableStart()).count() * 1000000ULL;
+
+    // a fixed offset since 1970 repeats 400 years on
+    std::vector<std::uint64_t> times = { 0, micros(1970, 6, 1) };
+    std::vector<TimeZoneOffset> offsets = { { -25000, 0, 0 }, { -21600, 0, 1 } };
+    EXPECT_EQ(micros(2371, 1, 1), TzSnapshot::repeatingEnd(times.data(), offsets.data(), times.size(), horizon));
+
+    // DST on fixed dates that moved in 2007
+    for (std::int32_t year = 1980; year < 2800; year++)
+    {
+        times.push_back(micros(year, year < 2007 ? 4 : 3, 10));
+        offsets.push_back({ -18000, 3600, 2 });
+        times.push_back(micros(year, year < 2007 ? 10 : 11, 3));
+        offsets.push_back({ -21600, 0, 1 });
+    }
+    EXPECT_EQ(micros(2407, 1, 1), TzSnapshot::repeatingEnd(times.data(), offsets.data(), times.size(), horizon));
+}
+
+TEST(TzSnapshotTest, RejectsDamagedImage)
+{
+    std::size_t size;
+    const void* embedded = TimezoneMapper::snapshotImage(&size);
+    std::vector<std::uint64_t> image((size + 7) / 8);
+    auto damaged = [&](auto damage) {
+        memcpy(image.data(), embedded, size);
+        damage((unsigned char*)image.data(), (const TzSnapshotHeader*)image.data());
+        TzSnapshot snapshot;
+        bool opened = snapshot.open(image.data(), size);
+        return opened || snapshot.isOpen();
+    };
+
+    EXPECT_FALSE(damaged([](unsigned char* bytes, const TzSnapshotHeader*) { bytes[0] = 'X'; }));
+    EXPECT_FALSE(damaged([size](unsigned char* bytes, const TzSnapshotHeader*) { bytes[size - 1] = 'X'; }));
+    EXPECT_FALSE(damaged([](unsigned char* bytes, const TzSnapshotHeader* header) {
+        ((TzSnapshotZone*)(bytes + header->m_zones))[header->m_zoneCount - 1].m_count = 0x7fffffff; }));
+    EXPECT_FALSE(damaged([](unsigned char* bytes, const TzSnapshotHeader* header) {
+        ((TzSnapshotZone*)(bytes + header->m_zones))[0].m_firstAbbrev = header->m_abbrevCount; }));
+    EXPECT_FALSE(damaged([size](unsigned char* bytes, const TzSnapshotHeader* header) {
+        ((TzSnapshotZone*)(bytes + header->m_zones))[0].m_name = (std::uint32_t)(size - header->m_strings); }));
+    EXPECT_FALSE(damaged([](unsigned char* bytes, const TzSnapshotHeader* header) {
+        ((TzSnapshotLink*)(bytes + header->m_links))[0].m_zone = header->m_zoneCount; }));
+    EXPECT_FALSE(damaged([size](unsigned char* bytes, const TzSnapshotHeader* header) {
+        ((std::uint32_t*)(bytes + header->m_abbrevs))[0] = (std::uint32_t)(size - header->m_strings); }));
+    EXPECT_TRUE(damaged([](unsigned char*, const TzSnapshotHeader*) { }));
+
+    TzSnapshot snapshot;
+    EXPECT_FALSE(snapshot.open(embedded, 16));
+}
+
+// runs in a child process, lazy loading only means anything before anything else has parsed the tzdb
+void lazyTzdbLocatesZones()
+{
+    using namespace date;
+
+    std::size_t size;
+    const void* image = TimezoneMapper::snapshotImage(&size);
+    TzSnapshot snapshot;
+    ASSERT_TRUE(snapshot.open(image, size));
+    ASSERT_EQ(0U, TimezoneMapper::tzdbFilesLoaded());
+
+    // a zone whose rules live in another region's file, ones that don't, and a link from backward
+    const std::pair<const char*, std::uint32_t> zones[] = {
+        { "America/Edmonton", TimezoneMapper::TZDB_NORTHAMERICA },
+        { "Antarctica/Palmer", TimezoneMapper::TZDB_ANTARCTICA | TimezoneMapper::TZDB_SOUTHAMERICA },
+        { "Asia/Famagusta", TimezoneMapper::TZDB_ASIA },
+        { "US/Pacific", TimezoneMapper::TZDB_NORTHAMERICA }
+    };
+    std::uint32_t expected_files = 0;
+    TimezoneMapper::setLazyTzdb(true);
+    for (auto& zone : zones)
+    {
+        const char* name = zone.first;
+        TimezoneMapper::loadTzdb(name);
+#if HAS_REMOTE_API
+        expected_files |= zone.second | TimezoneMapper::TZDB_BACKWARD;
+        EXPECT_EQ(expected_files, TimezoneMapper::tzdbFilesLoaded()) << name;
+        EXPECT_FALSE(TimezoneMapper::tzdbFullyLoaded()) << name;
+#else
+        // without reload_tzdb there's nothing lazy about it
+        EXPECT_TRUE(TimezoneMapper::tzdbFullyLoaded()) << name;
+#endif
+
+        HSS_Time::TimeZoneTransitions transitions;
+        ASSERT_TRUE(snapshot.find(name, nullptr, &transitions));
+        const time_zone* tz = locate_zone(name);
+        for (auto day : { sys_days{ 1950_y / jul / 1 }, sys_days{ 2022_y / jan / 2 }, sys_days{ 2022_y / jul / 2 } })
+        {
+            sys_info info = tz->get_info(day);
+            std::uint64_t t = (std::uint64_t)(day - TzSnapshot::tableStart()).count() * 1000000ULL;
+            EXPECT_EQ(transitions.find(t).m_offset, info.offset.count()) << name;
+        }
+    }
+}
+
+TEST(TzSnapshotTest, LazyTzdbLocatesZones)
+{
+    // threadsafe starts the child from scratch rather than forking this process, whatever it has already loaded
+    GTEST_FLAG_SET(death_test_style, "threadsafe");
+    EXPECT_EXIT({ lazyTzdbLocatesZones(); exit(::testing::Test::HasFailure() ? 1 : 0); }, ::testing::ExitedWithCode(0), "");
+}
+
+TEST(TzSnapshotTest, MatchesTzdb)
+{
+    TimezoneMapper::loadTzdb();
+
+    for (const char* name : { "America/Edmonton", "America/St_Johns", "Australia/Sydney", "Europe/London", "Asia/Kolkata", "America/Sao_Paulo" })
+    {
+        const TimeZoneInfo* tzi = WorldLocation::TimeZoneFromName(name, 0);
+        ASSERT_NE(nullptr, tzi);
+        ASSERT_NE(nullptr, tzi->m_transitions);
+
+        std::vector<std::uint64_t> times;
+        std::vector<TimeZoneOffset> offsets;
+        std::vector<std::string> abbrevs;
+        const std::uint64_t end = TzSnapshot::walk(date::locate_zone(name), TzSnapshot::tableEnd(), times, offsets, abbrevs);
+
+        EXPECT_EQ(end, tzi->m_transitions->m_end) << name;
+        ASSERT_EQ(times.size(), tzi->m_transitions->m_count) << name;
+        for (size_t i = 0; i < times.size(); i++)
+        {
+            EXPECT_EQ(times[i], tzi->m_transitions->m_times[i]) << name;
+            EXPECT_EQ(offsets[i].m_offset, tzi->m_transitions->m_offsets[i].m_offset) << name;
+            EXPECT_EQ(offsets[i].m_save, tzi->m_transitions->m_offsets[i].m_save) << name;
+            EXPECT_STREQ(abbrevs[offsets[i].m_abbrev].c_str(), tzi->m_transitions->m_abbrevs[tzi->m_transitions->m_offsets[i].m_abbrev]) << name;
+        }
+    }
+}
+}
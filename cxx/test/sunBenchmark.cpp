@@ -0,0 +1,169 @@
+/**
+ * sunBenchmark.cpp
+ *
+ * Copyright 2016-2023 Heartland Software Solutions Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the license at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the LIcense is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark.h"
+#include "WTime.h"
+
+#include <string>
+#include <vector>
+
+using namespace HSS_Time;
+using namespace HSS_Time_Benchmark;
+
+
+// a fire season of hourly weather at one station, asking for the day's sunrise and sunset every hour the way the fire
+// weather loop does, with the cache off and at a few capacities
+WTIME_BENCHMARK(SunRiseSetHourly)
+{
+	WorldLocation location(53.55, -113.49, false);
+	location.m_timezone(WTimeSpan(0, -7, 0, 0));
+	WTimeManager manager(location);
+	constexpr int hours = 24 * 183;
+
+	for (std::size_t capacity : { 0, 4, 16 })
+	{
+		location.SetSunCacheCapacity(capacity);
+		WTime rise(&manager), set(&manager), noon(&manager);
+		WTime t(2023, 4, 1, 0, 0, 0, &manager);
+
+		Stopwatch watch;
+		for (int hour = 0; hour < hours; hour++, t += WTimeSpan(0, 1, 0, 0))
+			keep(location.m_sun_rise_set(t, &rise, &set, &noon));
+		double seconds = watch.seconds();
+
+		std::uint64_t hits, misses;
+		location.GetSunCacheStatistics(&hits, &misses);
+		std::string label = "capacity=" + std::to_string(capacity);
+		report(label, seconds * 1e9 / hours, "ns/call");
+		report(label + " hit rate", (hits + misses) ? 100.0 * hits / (hits + misses) : 0.0, "%");
+	}
+}
+
+
+// a grid of cells all asking for the same day, the case the shared ephemeris table is for: only the hour angle and the
+// refinement pass are left per location
+WTIME_BENCHMARK(SunRiseSetGrid)
+{
+	constexpr int rows = 100, cols = 100, days = 7;
+	HSS_Time_Private::CSunriseSunsetCalc calc;
+	HSS_Time_Private::RISESET_IN_STRUCT in;
+	HSS_Time_Private::RISESET_OUT_STRUCT out;
+
+	Stopwatch watch;
+	for (int day = 0; day < days; day++)
+		for (int row = 0; row < rows; row++)
+			for (int col = 0; col < cols; col++)
+			{
+				in.Latitude = 45.0 + 15.0 * row / rows;
+				in.Longitude = 110.0 + 10.0 * col / cols;
+				in.year = 2023;
+				in.month = 7;
+				in.day = 1 + day;
+				in.timezone = 0;
+				in.DaytimeSaving = false;
+				keep(calc.calcSun(in, &out));
+			}
+	report("cells", watch.seconds() * 1e9 / (rows * cols * days), "ns/cell");
+}
+
+
+// a 1000x1000 cell fire growth grid over western Canada, every cell's sunrise and sunset in one batch, against a cell at
+// a time through the cache free single position call
+WTIME_BENCHMARK(SunRiseSetBatch)
+{
+	constexpr std::size_t rows = 1000, cols = 1000, cells = rows * cols, sampled = cells / 10;
+	WorldLocation location(53.55, -113.49, false);
+	location.m_timezone(WTimeSpan(0, -7, 0, 0));
+	location.SetSunCacheCapacity(0);
+	WTimeManager manager(location);
+	WTime t(2023, 7, 1, 12, 0, 0, &manager);
+
+	std::vector<double> latitude(cells), longitude(cells);
+	WorldLocation corner(49.0, -120.0, false), opposite(60.0, -110.0, false);
+	for (std::size_t row = 0; row < rows; row++)
+		for (std::size_t col = 0; col < cols; col++)
+		{
+			latitude[row * cols + col] = corner.m_latitude() + (opposite.m_latitude() - corner.m_latitude()) * row / rows;
+			longitude[row * cols + col] = corner.m_longitude() + (opposite.m_longitude() - corner.m_longitude()) * col / cols;
+		}
+	std::vector<std::uint64_t> rise(cells), set(cells), noon(cells);
+	std::vector<std::int16_t> success(cells);
+
+	Stopwatch watch;
+	location.m_sun_rise_set(latitude.data(), longitude.data(), cells, t, rise.data(), set.data(), noon.data(), success.data());
+	report("batch", watch.seconds() * 1e9 / cells, "ns/cell");
+	keep(rise[cells / 2]);
+
+	WTime r(&manager), s(&manager), n(&manager);
+	watch.restart();
+	for (std::size_t i = 0; i < sampled; i++)
+		keep(location.m_sun_rise_set(latitude[i * 10], longitude[i * 10], t, &r, &s, &n));
+	report("single", watch.seconds() * 1e9 / sampled, "ns/cell");
+}
+
+
+// a fire season of one minute simulation steps at one location, the sun's elevation and azimuth at every step
+WTIME_BENCHMARK(SolarPositionSeries)
+{
+	constexpr std::size_t steps = 183 * 24 * 60;
+	constexpr std::int64_t minute = 60LL * 1000000LL;
+	WorldLocation location(53.55, -113.49, false);
+	WTimeManager manager(location);
+	const std::uint64_t start = WTime(2023, 4, 1, 0, 0, 0, &manager).GetTotalMicroSeconds();
+	std::vector<double> elevation(steps), azimuth(steps);
+	std::vector<std::uint64_t> times(steps);
+	for (std::size_t i = 0; i < steps; i++)
+		times[i] = start + i * minute;
+
+	HSS_Time_Private::SolarPosition position(location.m_latitude(), location.m_longitude());
+	Stopwatch watch;
+	position.Positions(start, minute, steps, elevation.data(), azimuth.data());
+	report("stepped", watch.seconds() * 1e9 / steps, "ns/step");
+	keep(elevation[steps / 2]);
+
+	watch.restart();
+	position.Positions(times.data(), steps, elevation.data(), azimuth.data());
+	report("times", watch.seconds() * 1e9 / steps, "ns/step");
+	keep(elevation[steps / 2]);
+
+	watch.restart();
+	for (std::size_t i = 0; i < steps; i += 100)
+		location.m_sun_position(WTime(times[i], &manager, false), &elevation[i], &azimuth[i]);
+	report("WorldLocation", watch.seconds() * 1e9 / (steps / 100), "ns/step");
+	keep(elevation[0]);
+}
+
+
+// a year of daily sunrise and sunset at high arctic stations, where polar days and nights send calcSun looking for the
+// nearest rise and set on another day
+WTIME_BENCHMARK(SunRiseSetPolar)
+{
+	for (double latitude : { 69.0, 82.5, 89.8 })
+	{
+		WorldLocation location(latitude, -62.35, false);
+		location.SetSunCacheCapacity(0);
+		WTimeManager manager(location);
+		WTime rise(&manager), set(&manager), noon(&manager);
+		WTime t(2023, 1, 1, 12, 0, 0, &manager);
+
+		Stopwatch watch;
+		for (int day = 0; day < 365; day++, t += WTimeSpan(1, 0, 0, 0))
+			keep(location.m_sun_rise_set(t, &rise, &set, &noon));
+		report("latitude=" + std::to_string(latitude), watch.seconds() * 1e9 / 365, "ns/call");
+	}
+}
@@ -0,0 +1,279 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "WTime.h"
+
+using namespace HSS_Time;
+using namespace HSS_Time_Private;
+
+
+namespace
+{
+WorldLocation edmontonLocation()
+{
+    WorldLocation location(53.55, -113.49, false);
+    location.m_timezone(WTimeSpan(0, -7, 0, 0));
+    return location;
+}
+
+TEST(SunCacheTest, HourlyLoopHitsOncePerDay)
+{
+    WorldLocation location = edmontonLocation(), uncached = edmontonLocation();
+    uncached.SetSunCacheCapacity(0);
+    WTimeManager manager(location);
+
+    WTime rise(&manager), set(&manager), noon(&manager);
+    WTime expectedRise(&manager), expectedSet(&manager), expectedNoon(&manager);
+    WTime t(2023, 6, 1, 0, 0, 0, &manager);
+    for (int hour = 0; hour < 24 * 10; hour++, t += WTimeSpan(0, 1, 0, 0))
+    {
+        INTNM::int16_t success = location.m_sun_rise_set(t, &rise, &set, &noon);
+        EXPECT_EQ(uncached.m_sun_rise_set(t, &expectedRise, &expectedSet, &expectedNoon), success);
+        EXPECT_EQ(expectedRise, rise);
+        EXPECT_EQ(expectedSet, set);
+        EXPECT_EQ(expectedNoon, noon);
+    }
+
+    // hourly times start part way through a solar day, so 10 days of them touch 11
+    std::uint64_t hits, misses;
+    location.GetSunCacheStatistics(&hits, &misses);
+    EXPECT_EQ(11, misses);
+    EXPECT_EQ(24 * 10 - 11, hits);
+
+    location.ClearSunCache();
+    location.GetSunCacheStatistics(&hits, &misses);
+    EXPECT_EQ(0, hits);
+    EXPECT_EQ(0, misses);
+}
+
+TEST(SunCacheTest, KeyedOnPosition)
+{
+    WorldLocation location = edmontonLocation();
+    WTimeManager manager(location);
+    WTime t(2023, 6, 1, 12, 0, 0, &manager);
+    WTime rise(&manager), set(&manager), noon(&manager), otherRise(&manager);
+
+    location.m_sun_rise_set(t, &rise, &set, &noon);
+    WorldLocation north(60.0, -113.49, false);
+    location.m_sun_rise_set(north.m_latitude(), north.m_longitude(), t, &otherRise, &set, &noon);
+    EXPECT_NE(rise, otherRise);
+    location.m_sun_rise_set(t, &otherRise, &set, &noon);
+    EXPECT_EQ(rise, otherRise);
+
+    std::uint64_t hits, misses;
+    location.GetSunCacheStatistics(&hits, &misses);
+    EXPECT_EQ(1, hits);
+    EXPECT_EQ(2, misses);
+}
+
+TEST(SunCacheTest, ClockKeepsReferencedEntries)
+{
+    SunCache cache(2);
+    SunCache::Value value = { 1, 2, 3, 0 }, found;
+    const SunCache::Key a(100, 0.5, -2.0), b(101, 0.5, -2.0), c(102, 0.5, -2.0);
+
+    cache.Store(a, value);
+    cache.Store(b, value);
+    EXPECT_TRUE(cache.Retrieve(a, &found));
+    cache.Store(c, value);								// b hasn't been used since it was stored so it goes
+    EXPECT_TRUE(cache.Retrieve(a, &found));
+    EXPECT_TRUE(cache.Retrieve(c, &found));
+    EXPECT_EQ(3, found.m_noon);
+    EXPECT_FALSE(cache.Retrieve(b, &found));
+
+    SunCache copy(cache);
+    EXPECT_EQ(2, copy.Capacity());
+    EXPECT_FALSE(copy.Retrieve(a, &found));
+
+    cache.SetCapacity(0);
+    cache.Store(a, value);
+    EXPECT_FALSE(cache.Retrieve(a, &found));
+}
+
+TEST(SunEphemerisTest, SharedTableFilledFromManyThreads)
+{
+    // days no other test asks for, so the threads race to fill the same blocks
+    constexpr int days = 200, cells = 64;
+    std::vector<RISESET_OUT_STRUCT> parallel(days * cells), serial(days * cells);
+    std::vector<INTNM::int16_t> parallelResult(days * cells), serialResult(days * cells);
+
+    auto input = [](int i)
+    {
+        RISESET_IN_STRUCT in;
+        std::memset(&in, 0, sizeof(in));
+        in.Latitude = -88.0 + 176.0 * (i % cells) / (cells - 1);
+        in.Longitude = 113.49 - 3.0 * (i % cells);
+        in.year = 2150 + (i / cells) / 28 / 12;
+        in.month = 1 + ((i / cells) / 28) % 12;
+        in.day = 1 + (i / cells) % 28;
+        return in;
+    };
+
+#pragma omp parallel for
+    for (int i = 0; i < days * cells; i++)
+    {
+        CSunriseSunsetCalc calc;
+        RISESET_IN_STRUCT in = input(i);
+        std::memset(&parallel[i], 0, sizeof(RISESET_OUT_STRUCT));
+        parallelResult[i] = calc.calcSun(in, &parallel[i]);
+    }
+    for (int i = 0; i < days * cells; i++)
+    {
+        CSunriseSunsetCalc calc;
+        RISESET_IN_STRUCT in = input(i);
+        std::memset(&serial[i], 0, sizeof(RISESET_OUT_STRUCT));
+        serialResult[i] = calc.calcSun(in, &serial[i]);
+        ASSERT_EQ(serialResult[i], parallelResult[i]) << i;
+        ASSERT_EQ(0, std::memcmp(&serial[i], &parallel[i], sizeof(RISESET_OUT_STRUCT))) << i;
+    }
+}
+
+TEST(SunBatchTest, MatchesSinglePosition)
+{
+    WorldLocation location = edmontonLocation();
+    location.SetSunCacheCapacity(0);
+    WTimeManager manager(location);
+    WTime t(2023, 9, 14, 12, 0, 0, &manager);
+
+    std::vector<double> latitude, longitude;
+    for (double lat : { -60.0, -33.9, 0.0, 21.3, 45.0, 53.55, 64.8 })
+        for (double lon : { -179.0, -113.49, -70.0, 0.0, 18.4, 151.2 })
+        {
+            WorldLocation position(lat, lon, false);
+            latitude.push_back(position.m_latitude());
+            longitude.push_back(position.m_longitude());
+        }
+    std::vector<INTNM::uint64_t> rise(latitude.size()), set(latitude.size()), noon(latitude.size());
+    std::vector<INTNM::int16_t> success(latitude.size());
+    location.m_sun_rise_set(latitude.data(), longitude.data(), latitude.size(), t, rise.data(), set.data(), noon.data(), success.data());
+
+    WTime expectedRise(&manager), expectedSet(&manager), expectedNoon(&manager);
+    for (std::size_t i = 0; i < latitude.size(); i++)
+    {
+        EXPECT_EQ(location.m_sun_rise_set(latitude[i], longitude[i], t, &expectedRise, &expectedSet, &expectedNoon), success[i]);
+        // the single position version truncates to the second, and rounds rise and set to the nearest minute while
+        // keeping the seconds
+        const INTNM::int64_t riseDiff = (INTNM::int64_t)rise[i] - (INTNM::int64_t)expectedRise.GetTotalMicroSeconds();
+        const INTNM::int64_t setDiff = (INTNM::int64_t)set[i] - (INTNM::int64_t)expectedSet.GetTotalMicroSeconds();
+        const INTNM::int64_t noonDiff = (INTNM::int64_t)noon[i] - (INTNM::int64_t)expectedNoon.GetTotalMicroSeconds();
+        EXPECT_TRUE((riseDiff >= -60000000) && (riseDiff <= 1000000)) << i << " " << riseDiff;
+        EXPECT_TRUE((setDiff >= -60000000) && (setDiff <= 1000000)) << i << " " << setDiff;
+        EXPECT_TRUE((noonDiff >= 0) && (noonDiff <= 1000000)) << i << " " << noonDiff;
+    }
+}
+
+TEST(SunBatchTest, PolarPositionsAreFlagged)
+{
+    WorldLocation location = edmontonLocation();
+    WTimeManager manager(location);
+    WorldLocation north(80.0, -113.49, false), south(-80.0, -113.49, false);
+    const double latitude[] = { north.m_latitude(), south.m_latitude() }, longitude[] = { north.m_longitude(), south.m_longitude() };
+    INTNM::uint64_t rise[2], set[2], noon[2];
+    INTNM::int16_t success[2];
+
+    location.m_sun_rise_set(latitude, longitude, 2, WTime(2023, 6, 21, 12, 0, 0, &manager), rise, set, noon, success);
+    for (int i = 0; i < 2; i++)
+    {
+        EXPECT_EQ(NO_SUNRISE | NO_SUNSET, success[i]);
+        EXPECT_EQ(0, rise[i]);
+        EXPECT_EQ(0, set[i]);
+        EXPECT_NE(0, noon[i]);
+    }
+}
+
+constexpr double DEGREE = 3.14159265358979323846264 / 180.0;
+
+TEST(SolarPositionTest, AtSunriseSunsetAndNoon)
+{
+    WorldLocation location = edmontonLocation();
+    WTimeManager manager(location);
+    const double latitude = location.m_latitude(), longitude = location.m_longitude();
+    SolarPosition position(latitude, longitude);
+
+    for (int month = 1; month <= 12; month++)
+    {
+        INTNM::uint64_t rise, set, noon;
+        INTNM::int16_t success;
+        location.m_sun_rise_set(&latitude, &longitude, 1, WTime(2023, month, 21, 12, 0, 0, &manager), &rise, &set, &noon, &success);
+        ASSERT_EQ(0, success);
+
+        // rise and set are when the centre of the sun is 0.833 degrees below the horizon, allowing for refraction
+        double elevation, azimuth;
+        position.Position(rise, &elevation, &azimuth);
+        EXPECT_NEAR(-0.833, elevation / DEGREE, 0.005) << month;
+        EXPECT_LT(azimuth, 180.0 * DEGREE);
+        position.Position(set, &elevation, &azimuth);
+        EXPECT_NEAR(-0.833, elevation / DEGREE, 0.005) << month;
+        EXPECT_GT(azimuth, 180.0 * DEGREE);
+        // solar noon uses the equation of time at the start of the day so it's a few seconds out
+        position.Position(noon, &elevation, &azimuth);
+        EXPECT_NEAR(180.0, azimuth / DEGREE, 0.15) << month;
+        if (month == 6)
+        {
+            EXPECT_NEAR(90.0 - 53.55 + 23.44, elevation / DEGREE, 0.01);
+        }
+    }
+
+    const WTime t(2023, 6, 21, 19, 25, 0, &manager);
+    double elevation, azimuth, expectedElevation, expectedAzimuth;
+    location.m_sun_position(t, &elevation, &azimuth);
+    position.Position(t.GetTotalMicroSeconds(), &expectedElevation, &expectedAzimuth);
+    EXPECT_EQ(expectedElevation, elevation);
+    EXPECT_EQ(expectedAzimuth, azimuth);
+}
+
+TEST(SolarPositionTest, SteppedMatchesEachTime)
+{
+    WorldLocation location = edmontonLocation();
+    WTimeManager manager(location);
+    const INTNM::uint64_t start = WTime(2023, 3, 18, 5, 30, 0, &manager).GetTotalMicroSeconds();
+
+    for (INTNM::int64_t step : { 60LL * 1000000LL, 3600LL * 1000000LL, -600LL * 1000000LL, 7LL * 3600LL * 1000000LL + 123LL })
+    {
+        constexpr std::size_t count = 24 * 60;
+        std::vector<double> elevation(count), azimuth(count);
+        SolarPosition stepped(location.m_latitude(), location.m_longitude()), single(location.m_latitude(), location.m_longitude());
+        stepped.Positions(start, step, count, elevation.data(), azimuth.data());
+
+        std::vector<INTNM::uint64_t> times(count);
+        std::vector<double> elevations(count), azimuths(count);
+        for (std::size_t i = 0; i < count; i++)
+            times[i] = start + (INTNM::int64_t)i * step;
+        single.Positions(times.data(), count, elevations.data(), azimuths.data());
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            ASSERT_NEAR(elevations[i], elevation[i], 1e-9) << step << " " << i;
+            ASSERT_NEAR(azimuths[i], azimuth[i], 1e-9) << step << " " << i;
+        }
+    }
+}
+
+TEST(SunPolarTest, PolarDayAndNightUseTheNearestRiseAndSet)
+{
+    WorldLocation location(82.5, -62.35, false);							// Alert, Nunavut
+    location.SetSunCacheCapacity(0);
+    WTimeManager manager(location);
+    WTime rise(&manager), set(&manager), noon(&manager);
+
+    // midnight sun from the 6th of April to the 7th of September
+    EXPECT_EQ(0, location.m_sun_rise_set(WTime(2023, 6, 21, 12, 0, 0, &manager), &rise, &set, &noon));
+    EXPECT_EQ(WTime(2023, 4, 6, 0, 0, 0, &manager).GetTotalSeconds() / 86400, rise.GetTotalSeconds() / 86400);
+    EXPECT_EQ(WTime(2023, 9, 7, 0, 0, 0, &manager).GetTotalSeconds() / 86400, set.GetTotalSeconds() / 86400);
+
+    // polar night from the 14th of October to the 28th of February
+    EXPECT_EQ(0, location.m_sun_rise_set(WTime(2023, 12, 21, 12, 0, 0, &manager), &rise, &set, &noon));
+    EXPECT_EQ(WTime(2024, 2, 28, 0, 0, 0, &manager).GetTotalSeconds() / 86400, rise.GetTotalSeconds() / 86400);
+    EXPECT_EQ(WTime(2023, 10, 14, 0, 0, 0, &manager).GetTotalSeconds() / 86400, set.GetTotalSeconds() / 86400);
+
+    for (double latitude : { 82.5, 89.0, -78.0 })
+    {
+        WorldLocation polar(latitude, -62.35, false);
+        WTime t(2023, 1, 1, 12, 0, 0, &manager);
+        for (int day = 0; day < 365; day++, t += WTimeSpan(1, 0, 0, 0))
+            EXPECT_EQ(0, location.m_sun_rise_set(polar.m_latitude(), polar.m_longitude(), t, &rise, &set, &noon)) << latitude << " " << day;
+    }
+}
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "WTime.h"
+
+
+// locations shared by the tests and benchmarks
+namespace HSS_Time_Test
+{
+	// Mountain time with the old style fixed DST window (day 69 09:00 to day 307 08:00), the way most weather streams are set up
+	inline HSS_Time::WorldLocation mountainLocation()
+	{
+		HSS_Time::WorldLocation location;
+		location.m_timezone(HSS_Time::WTimeSpan(0, -7, 0, 0));
+		location.m_startDST(HSS_Time::WTimeSpan(69, 9, 0, 0));
+		location.m_endDST(HSS_Time::WTimeSpan(307, 8, 0, 0));
+		location.m_amtDST(HSS_Time::WTimeSpan(0, 1, 0, 0));
+		return location;
+	}
+}
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "WTime.h"
+#include "testLocations.h"
+
+using namespace HSS_Time;
+using namespace HSS_Time_Test;
+
+
+namespace
+{
+std::vector<INTNM::uint32_t> formatterFlags()
+{
+    const INTNM::uint32_t styles[] = { 0, WTIME_FORMAT_STRING_DD_MM_YYYY, WTIME_FORMAT_STRING_YYYY_MM_DD, WTIME_FORMAT_STRING_MM_DD_YYYY,
+        WTIME_FORMAT_STRING_DDhMMhYYYY, WTIME_FORMAT_STRING_YYYYhMMhDD, WTIME_FORMAT_STRING_MMhDDhYYYY, WTIME_FORMAT_STRING_YYYYMMDD,
+        WTIME_FORMAT_STRING_YYYYMMDDHH, WTIME_FORMAT_STRING_YYYYMMDDT, WTIME_FORMAT_STRING_YYYYhMMhDDT };
+    const INTNM::uint32_t options[] = { WTIME_FORMAT_YEAR, WTIME_FORMAT_MONTH, WTIME_FORMAT_DAY, WTIME_FORMAT_TIME,
+        WTIME_FORMAT_DAY_OF_WEEK, WTIME_FORMAT_ABBREV, WTIME_FORMAT_EXCLUDE_SECONDS, WTIME_FORMAT_INCLUDE_USECS,
+        WTIME_FORMAT_CONDITIONAL_TIME, WTIME_FORMAT_STRING_TIMEZONE };
+    const INTNM::uint32_t zones[] = { 0, WTIME_FORMAT_AS_LOCAL, WTIME_FORMAT_AS_LOCAL | WTIME_FORMAT_WITHDST };
+
+    std::vector<INTNM::uint32_t> flags;
+    for (INTNM::uint32_t style : styles)
+        for (INTNM::uint32_t mask = 0; mask < (1u << 10); mask++)
+            for (INTNM::uint32_t zone : zones)
+            {
+                INTNM::uint32_t f = style | zone;
+                for (int bit = 0; bit < 10; bit++)
+                    if (mask & (1u << bit))
+                        f |= options[bit];
+                flags.push_back(f);
+            }
+    return flags;
+}
+
+TEST(WTimeFormatterTest, MatchesWTimeToString)
+{
+    WorldLocation location = mountainLocation();
+    WTimeManager manager(location);
+
+    std::vector<WTime> times;
+    times.push_back(WTime((INTNM::uint64_t)-1, &manager, false));
+    times.push_back(WTime(2023, 1, 1, 0, 0, 0, &manager));
+    times.push_back(WTime(2023, 3, 12, 9, 0, 0, &manager));
+    times.push_back(WTime(2023, 7, 4, 23, 59, 45, &manager));
+    times.push_back(WTime(1601, 1, 1, 0, 0, 0, &manager));
+    times.push_back(WTime(2024, 2, 29, 12, 34, 56, &manager) + WTimeSpan(0, 0, 0, 0, 123456));
+    times.push_back(WTime(1999, 12, 31, 7, 0, 0, nullptr));
+    std::mt19937_64 random(18);
+    for (int i = 0; i < 8; i++)
+        times.push_back(WTime(WTime(1900, 1, 1, 0, 0, 0, &manager).GetTotalMicroSeconds() + random() % (200ULL * 366 * 86400 * 1000000), &manager, false));
+
+    char buffer[WTimeFormatter::MAX_LENGTH];
+    for (INTNM::uint32_t flags : formatterFlags())
+    {
+        WTimeFormatter formatter(flags);
+        for (const WTime& t : times)
+        {
+            std::string expected = t.ToString(flags);
+            ASSERT_EQ(expected.length(), formatter.Format(t, buffer, sizeof(buffer))) << std::hex << flags;
+            ASSERT_EQ(expected, buffer) << std::hex << flags;
+
+            std::string appended("x");
+            formatter.Append(t, appended);
+            ASSERT_EQ("x" + expected, appended) << std::hex << flags;
+        }
+    }
+}
+
+TEST(WTimeFormatterTest, MatchesWTimeSpanToString)
+{
+    std::vector<WTimeSpan> spans;
+    spans.push_back(WTimeSpan());
+    spans.push_back(WTimeSpan(0, 0, 0, 29));
+    spans.push_back(WTimeSpan(0, 0, 0, 30));
+    spans.push_back(WTimeSpan(0, 0, 59, 30));
+    spans.push_back(WTimeSpan(0, 23, 59, 30));
+    spans.push_back(WTimeSpan(1, 0, 0, 0));
+    spans.push_back(WTimeSpan(3, 4, 5, 6, 7));
+    spans.push_back(WTimeSpan(366, 0, 0, 0));
+    spans.push_back(WTimeSpan(800, 12, 0, 1, 500000));
+    spans.push_back(WTimeSpan(0, 0, 0, 0, 120));
+    std::mt19937_64 random(18);
+    for (int i = 0; i < 8; i++)
+        spans.push_back(WTimeSpan((INTNM::int64_t)(random() % (1000ULL * 86400 * 1000000)), false));
+    for (std::size_t i = 0, count = spans.size(); i < count; i++)
+        spans.push_back(WTimeSpan(0 - spans[i].GetTotalMicroSeconds(), false));
+
+    char buffer[WTimeFormatter::MAX_LENGTH];
+    for (INTNM::uint32_t flags : formatterFlags())
+    {
+        WTimeFormatter formatter(flags);
+        for (const WTimeSpan& s : spans)
+        {
+            std::string expected = s.ToString(flags);
+            ASSERT_EQ(expected.length(), formatter.Format(s, buffer, sizeof(buffer))) << std::hex << flags;
+            ASSERT_EQ(expected, buffer) << std::hex << flags;
+        }
+    }
+}
+
+TEST(WTimeFormatterTest, TruncatesLikeSnprintf)
+{
+    WTimeFormatter formatter(WTIME_FORMAT_STRING_YYYYhMMhDDT | WTIME_FORMAT_DATE | WTIME_FORMAT_TIME);
+    WTime t(2023, 7, 4, 12, 30, 0, nullptr);
+    const std::string expected = t.ToString(formatter.Flags());
+
+    char buffer[8] = "#######";
+    EXPECT_EQ(expected.length(), formatter.Format(t, buffer, sizeof(buffer)));
+    EXPECT_EQ(expected.substr(0, 7), buffer);
+
+    EXPECT_EQ(expected.length(), formatter.Format(t, nullptr, 0));
+}
+}
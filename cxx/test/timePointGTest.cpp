@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "WTime.h"
+
+using namespace HSS_Time;
+
+
+namespace
+{
+TEST(WTimePointTest, RoundTripsWTime)
+{
+    WorldLocation location;
+    location.m_timezone(WTimeSpan(0, -6, 0, 0));
+    WTimeManager manager(location);
+
+    WTime t(2021, 6, 15, 13, 45, 10, 250, &manager);
+    WTimePoint point(t);
+    EXPECT_EQ(t.GetTotalMicroSeconds(), point.GetTotalMicroSeconds());
+    EXPECT_EQ(t.GetTotalSeconds(), point.GetTotalSeconds());
+
+    WTime back = point.ToWTime(&manager);
+    EXPECT_EQ(t, back);
+    EXPECT_EQ(&manager, back.GetTimeManager());
+    EXPECT_EQ(7, back.GetHour(WTIME_FORMAT_AS_LOCAL));
+}
+
+TEST(WTimePointTest, MathMatchesWTime)
+{
+    WTime t(2021, 1, 31, 23, 0, 0, nullptr);
+    WTimePoint point(t);
+    WTimeSpan span(1, 2, 3, 4, 5);
+
+    EXPECT_EQ((t + span).GetTotalMicroSeconds(), (point + span).GetTotalMicroSeconds());
+    EXPECT_EQ((t - span).GetTotalMicroSeconds(), (point - span).GetTotalMicroSeconds());
+    WTimePoint later = point;
+    later += span;
+    EXPECT_EQ(span, later - point);
+    EXPECT_EQ(WTimeSpan(0) - span, point - later);
+    later -= span;
+    EXPECT_EQ(point, later);
+
+    WTimePoint unset = WTimePoint::Unset();
+    EXPECT_FALSE(unset.IsValid());
+    EXPECT_FALSE((unset + span).IsValid());
+    unset -= span;
+    EXPECT_FALSE(unset.IsValid());
+    EXPECT_TRUE(point < unset);
+}
+
+TEST(WTimePointTest, SortMatchesStdSort)
+{
+    std::mt19937_64 random(20230401);
+    const WTimePoint start(WTime(2000, 1, 1, 0, 0, 0, nullptr));
+    for (std::size_t count : { (std::size_t)0, (std::size_t)1, (std::size_t)100, (std::size_t)5000, (std::size_t)100000 })
+    {
+        // a few years of times with duplicates, plus the odd time from anywhere
+        std::vector<WTimePoint> times(count);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            if ((i % 1000) == 999)
+                times[i] = WTimePoint(random());
+            else
+                times[i] = start + WTimeSpan((INTNM::int64_t)(random() % (3ULL * 365 * 24 * 60 * 60)) * 1000000, false);
+        }
+        if (count > 10)
+            times[count / 2] = times[count / 3];
+
+        std::vector<WTimePoint> expected = times;
+        std::sort(expected.begin(), expected.end());
+        WTimePoint::Sort(times.data(), times.size());
+        ASSERT_EQ(expected, times) << count;
+    }
+}
+
+TEST(WTimePointTest, WorksInContainers)
+{
+    WTimePoint a(WTime(2020, 1, 1, 0, 0, 0, nullptr)), b(WTime(2020, 1, 1, 1, 0, 0, nullptr));
+    std::unordered_set<WTimePoint> set{ a, b, a };
+    EXPECT_EQ(2, set.size());
+    EXPECT_EQ(1, set.count(b));
+}
+}
@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+#ifdef WTIME_TEST_EXECUTION
+#include <execution>
+#endif
+
+#include "WTime.h"
+#include "testLocations.h"
+
+using namespace HSS_Time;
+using namespace HSS_Time_Test;
+
+
+namespace
+{
+TEST(WTimeRangeTest, FixedStep)
+{
+    WTime begin(2022, 1, 1, 0, 0, 0, nullptr);
+    WTimeRange range(begin, begin + WTimeSpan(1, 0, 0, 0), WTimeSpan(0, 1, 0, 0));
+    ASSERT_EQ(24, range.Size());
+    EXPECT_EQ(begin + WTimeSpan(0, 5, 0, 0), range[5]);
+
+    WTime expected(begin);
+    std::size_t count = 0;
+    for (const WTime& t : range)
+    {
+        EXPECT_EQ(expected, t);
+        expected += WTimeSpan(0, 1, 0, 0);
+        count++;
+    }
+    EXPECT_EQ(24, count);
+
+    EXPECT_EQ(24, range.end() - range.begin());
+    EXPECT_EQ(range[20], *(range.end() - 4));
+    EXPECT_EQ(range[3], range.begin()[3]);
+
+    EXPECT_EQ(2, WTimeRange(begin, begin + WTimeSpan(0, 1, 30, 0), WTimeSpan(0, 1, 0, 0)).Size());
+    EXPECT_TRUE(WTimeRange(begin, begin, WTimeSpan(0, 1, 0, 0)).IsEmpty());
+    EXPECT_TRUE(WTimeRange(begin, begin - WTimeSpan(0, 1, 0, 0), WTimeSpan(0, 1, 0, 0)).IsEmpty());
+}
+
+TEST(WTimeRangeTest, LocalDaysAcrossDST)
+{
+    WorldLocation location = mountainLocation();
+    WTimeManager manager(location);
+    const INTNM::uint32_t flags = WTIME_FORMAT_AS_LOCAL | WTIME_FORMAT_WITHDST;
+
+    // starts part way through a day so the first time is the next local midnight
+    WTime begin(2023, 1, 1, 12, 0, 0, &manager);
+    WTime end(2024, 1, 1, 12, 0, 0, &manager);
+    WTimeRange range(begin, end, ITERATION_1DAY, flags);
+    ASSERT_EQ(365, range.Size());
+
+    // the loop this replaces, an hour into each day so PurgeToDay doesn't see the DST change later that day
+    WTime t(begin);
+    t.PurgeToDay(flags);
+    t += WTimeSpan(1, 1, 0, 0);
+    bool short_day = false, long_day = false;
+    for (std::size_t i = 0; i < range.Size(); i++, t += WTimeSpan(1, 0, 0, 0))
+    {
+        WTime expected(t);
+        expected.PurgeToDay(flags);
+        ASSERT_EQ(expected, range[i]) << i;
+        ASSERT_EQ(0, range[i].GetHour(flags)) << i;
+        ASSERT_GE(range[i], begin);
+        ASSERT_LT(range[i], end);
+        if (i)
+        {
+            INTNM::int64_t hours = (range[i] - range[i - 1]).GetTotalHours();
+            short_day |= (hours == 23);
+            long_day |= (hours == 25);
+        }
+    }
+    EXPECT_TRUE(short_day);
+    EXPECT_TRUE(long_day);
+}
+
+TEST(WTimeRangeTest, LocalHoursWithHalfHourOffset)
+{
+    WorldLocation location;
+    location.m_timezone(WTimeSpan(0, -3, -30, 0));
+    WTimeManager manager(location);
+
+    WTimeRange range(WTime(2022, 5, 1, 0, 10, 0, &manager), WTime(2022, 5, 3, 0, 0, 0, &manager), ITERATION_1HOUR, WTIME_FORMAT_AS_LOCAL);
+    ASSERT_EQ(48, range.Size());
+    for (const WTime& t : range)
+        ASSERT_EQ(0, t.GetMinute(WTIME_FORMAT_AS_LOCAL));
+    EXPECT_EQ(WTime(2022, 5, 1, 0, 30, 0, &manager), range[0]);
+    EXPECT_EQ(&manager, range[0].GetTimeManager());
+
+    // without a time manager there's nothing to align to
+    WTimeRange utc(WTime(2022, 5, 1, 0, 10, 0, nullptr), WTime(2022, 5, 3, 0, 0, 0, nullptr), ITERATION_1HOUR, WTIME_FORMAT_AS_LOCAL);
+    EXPECT_EQ(WTime(2022, 5, 1, 0, 10, 0, nullptr), utc[0]);
+}
+
+TEST(WTimeRangeTest, RandomAccessFromThreads)
+{
+    WorldLocation location;
+    location.m_timezone(WTimeSpan(0, 10, 0, 0));
+    location.m_startDST(WTimeSpan(276, 2, 0, 0));
+    location.m_endDST(WTimeSpan(95, 3, 0, 0));
+    location.m_amtDST(WTimeSpan(0, 1, 0, 0));
+    WTimeManager manager(location);
+
+    WTimeRange range(WTime(2000, 1, 1, 0, 0, 0, &manager), WTime(2020, 1, 1, 0, 0, 0, &manager), ITERATION_1HOUR,
+        WTIME_FORMAT_AS_LOCAL | WTIME_FORMAT_WITHDST);
+    std::vector<INTNM::uint64_t> serial, parallel(range.Size());
+    for (const WTime& t : range)
+        serial.push_back(t.GetTotalMicroSeconds());
+
+    auto first = range.begin();
+    #pragma omp parallel for
+    for (std::int64_t i = 0; i < (std::int64_t)range.Size(); i++)
+        parallel[i] = first[i].GetTotalMicroSeconds();
+    EXPECT_EQ(serial, parallel);
+    EXPECT_TRUE(std::is_sorted(serial.begin(), serial.end()));
+}
+
+#ifdef WTIME_TEST_EXECUTION
+TEST(WTimeRangeTest, ParallelAlgorithms)
+{
+    WorldLocation location = mountainLocation();
+    WTimeManager manager(location);
+
+    WTimeRange range(WTime(2000, 1, 1, 0, 0, 0, &manager), WTime(2020, 1, 1, 0, 0, 0, &manager), ITERATION_1HOUR,
+        WTIME_FORMAT_AS_LOCAL | WTIME_FORMAT_WITHDST);
+    std::vector<INTNM::uint64_t> serial, parallel(range.Size());
+    for (const WTime& t : range)
+        serial.push_back(t.GetTotalMicroSeconds());
+
+    std::transform(std::execution::par, range.begin(), range.end(), parallel.begin(),
+        [](const WTime& t) { return t.GetTotalMicroSeconds(); });
+    EXPECT_EQ(serial, parallel);
+    EXPECT_EQ((std::ptrdiff_t)range.Size(), std::count_if(std::execution::par, range.begin(), range.end(),
+        [](const WTime& t) { return t.GetMinute(WTIME_FORMAT_AS_LOCAL) == 0; }));
+}
+#endif
+}
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "WTime.h"
+
+using namespace HSS_Time;
+
+
+namespace
+{
+// the answers the series should give, by walking every entry
+static void expectQueries(const WTimeSeriesView<double>& view, WTimePoint time)
+{
+    std::size_t find = WTimeSeriesView<double>::npos, floor = WTimeSeriesView<double>::npos, ceil = WTimeSeriesView<double>::npos,
+        nearest = WTimeSeriesView<double>::npos;
+    INTNM::uint64_t t = time.GetTotalMicroSeconds(), best = (INTNM::uint64_t)-1;
+    for (std::size_t i = 0; i < view.Size(); i++)
+    {
+        INTNM::uint64_t entry = view.Times()[i];
+        if (entry == t)
+            find = i;
+        if (entry <= t)
+            floor = i;
+        if ((entry >= t) && (ceil == WTimeSeriesView<double>::npos))
+            ceil = i;
+        INTNM::uint64_t distance = (entry > t) ? entry - t : t - entry;
+        if (distance < best)
+        {
+            best = distance;
+            nearest = i;
+        }
+    }
+    ASSERT_EQ(find, view.Find(time)) << t;
+    ASSERT_EQ(floor, view.Floor(time)) << t;
+    ASSERT_EQ(ceil, view.Ceil(time)) << t;
+    ASSERT_EQ(nearest, view.Nearest(time)) << t;
+}
+
+TEST(WTimeSeriesTest, RegularSeries)
+{
+    WTimeSeries<double> series(nullptr);
+    WTime start(2022, 1, 1, 0, 0, 0, nullptr);
+    WTimeSpan hour(0, 1, 0, 0);
+    for (int i = 0; i < 1000; i++)
+        ASSERT_TRUE(series.Append(start + hour * i, i * 0.5));
+
+    EXPECT_TRUE(series.IsRegular());
+    EXPECT_EQ(hour, series.Step());
+    EXPECT_EQ(ITERATION_1HOUR, series.Cadence());
+    EXPECT_EQ(10, series.Find(start + hour * 10));
+    EXPECT_EQ(5.0, series.Value(series.Find(start + hour * 10)));
+
+    WTimePoint probe(start - WTimeSpan(0, 2, 0, 0));
+    const WTimeSpan step(0, 0, 17, 0);
+    for (int i = 0; i < 3600; i++, probe += step)
+        expectQueries(series.AsView(), probe);
+
+    EXPECT_FALSE(series.Append(start, 0.0));
+    EXPECT_FALSE(series.Append(WTimePoint::Unset(), 0.0));
+    EXPECT_EQ(1000, series.Size());
+    EXPECT_EQ(WTimeSeries<double>::npos, series.Find(WTimePoint::Unset()));
+}
+
+TEST(WTimeSeriesTest, IrregularSeries)
+{
+    std::mt19937_64 random(1776);
+    WTimeSeries<double> series(nullptr);
+    WTimePoint time(WTime(2010, 6, 1, 0, 0, 0, nullptr));
+    for (int i = 0; i < 777; i++)
+    {
+        time += WTimeSpan((INTNM::int64_t)(1 + random() % 7200), true);
+        ASSERT_TRUE(series.Append(time, i));
+    }
+    EXPECT_FALSE(series.IsRegular());
+    EXPECT_EQ(-1, series.Cadence());
+
+    WTimePoint last = series.Point(series.Size() - 1);
+    WTimePoint probe = series.Point(0) - WTimeSpan(0, 1, 0, 0);
+    while (probe < last + WTimeSpan(0, 1, 0, 0))
+    {
+        expectQueries(series.AsView(), probe);
+        probe += WTimeSpan((INTNM::int64_t)(random() % 1800), true);
+    }
+    for (std::size_t i = 0; i < series.Size(); i++)
+        expectQueries(series.AsView(), series.Point(i));
+
+    // the series was regular until the third entry broke the pattern
+    WTimeSeries<int> broken(nullptr);
+    broken.Append(WTimePoint(0), 0);
+    broken.Append(WTimePoint(10), 1);
+    EXPECT_TRUE(broken.IsRegular());
+    broken.Append(WTimePoint(25), 2);
+    EXPECT_FALSE(broken.IsRegular());
+}
+
+TEST(WTimeSeriesTest, SliceDoesNotCopy)
+{
+    WTimeSeries<double> series(nullptr);
+    WTime start(2022, 1, 1, 0, 0, 0, nullptr);
+    WTimeSpan day(1, 0, 0, 0);
+    for (int i = 0; i < 365; i++)
+        series.Append(start + day * i, i);
+
+    WTimeSeriesView<double> march = series.Slice(WTime(2022, 3, 1, 0, 0, 0, nullptr), WTime(2022, 4, 1, 0, 0, 0, nullptr));
+    EXPECT_EQ(31, march.Size());
+    EXPECT_EQ(series.Values() + 59, march.Values());
+    EXPECT_EQ(59.0, march.Value(0));
+    EXPECT_EQ(ITERATION_1DAY, march.Cadence());
+    EXPECT_EQ(9, march.Find(WTime(2022, 3, 10, 0, 0, 0, nullptr)));
+    EXPECT_EQ(30, march.Floor(WTime(2022, 7, 1, 0, 0, 0, nullptr)));
+    for (int i = -50; i < 100; i++)
+        expectQueries(march, WTimePoint(WTime(2022, 3, 1, 7, 0, 0, nullptr)) + day * i);
+
+    EXPECT_TRUE(series.Slice(WTime(2023, 3, 1, 0, 0, 0, nullptr), WTime(2023, 4, 1, 0, 0, 0, nullptr)).IsEmpty());
+    EXPECT_EQ(5, march.Slice(26, 100).Size());
+    EXPECT_TRUE(march.Slice(20, 10).IsEmpty());
+}
+}
@@ -0,0 +1,270 @@
+/**
+ * timezoneBenchmark.cpp
+ *
+ * Copyright 2016-2023 Heartland Software Solutions Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the license at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the LIcense is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark.h"
+#include "WTime.h"
+#include "TimeZoneMapper.h"
+#include "date/tz.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace HSS_Time;
+using namespace HSS_Time_Benchmark;
+
+
+static const char* zone_names[] = {
+	"America/St_Johns", "America/Halifax", "America/Toronto", "America/Winnipeg", "America/Regina",
+	"America/Edmonton", "America/Vancouver", "America/Whitehorse", "America/New_York", "America/Chicago",
+	"America/Denver", "America/Phoenix", "America/Los_Angeles", "America/Anchorage", "Pacific/Honolulu",
+	"America/Sao_Paulo", "Europe/London", "Europe/Paris", "Europe/Berlin", "Europe/Moscow",
+	"Africa/Cairo", "Africa/Johannesburg", "Asia/Kolkata", "Asia/Shanghai", "Asia/Tokyo",
+	"Australia/Perth", "Australia/Sydney", "Pacific/Auckland"
+};
+static constexpr size_t zone_count = sizeof(zone_names) / sizeof(zone_names[0]);
+
+
+// lookups of zones that are already registered, which is the steady state for any caller, run with
+// 1..hardware_concurrency threads so contention on the read path shows up as flat or falling throughput
+WTIME_BENCHMARK(TimezoneLookupScaling)
+{
+	constexpr int iterations = 200000;
+
+	std::vector<std::uint32_t> ids;
+	for (auto name : zone_names)
+		ids.push_back(WorldLocation::TimeZoneFromName(name, 0)->m_id);
+
+	unsigned int max_threads = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned int thread_count = 1; thread_count <= max_threads; thread_count *= 2)
+	{
+		Stopwatch watch;
+		std::vector<std::thread> threads;
+		for (unsigned int t = 0; t < thread_count; t++)
+		{
+			threads.emplace_back([&ids, t]()
+			{
+				for (int i = 0; i < iterations; i++)
+				{
+					size_t index = (i + t) % zone_count;
+					keep(WorldLocation::TimeZoneFromName(zone_names[index], 0));
+					keep(WorldLocation::TimeZoneFromId(ids[index]));
+				}
+			});
+		}
+		for (auto& thread : threads)
+			thread.join();
+		double seconds = watch.seconds();
+
+		report("threads=" + std::to_string(thread_count), 2.0 * iterations * thread_count / seconds / 1.0e6, "Mlookups/s");
+	}
+}
+
+
+// resolves a dense grid over western Canada twice, first with the tile cache disabled then with it enabled, the way
+// a fire growth landscape would query neighbouring cells
+WTIME_BENCHMARK(TimezoneTileCache)
+{
+	constexpr double degree = 0.017453292519943295;
+	constexpr int rows = 100, columns = 100;
+	double resolution = WorldLocation::GetTimeZoneTileResolution();
+
+	for (double tile : { 0.0, 0.01, 0.05 })
+	{
+		WorldLocation::SetTimeZoneTileResolution(tile);
+		WorldLocation::ClearTimeZoneTileCache();
+
+		Stopwatch watch;
+		for (int r = 0; r < rows; r++)
+			for (int c = 0; c < columns; c++)
+				keep(WorldLocation::TimeZoneFromLatLon((50.0 + r * 0.005) * degree, (-112.0 + c * 0.005) * degree, 0));
+		double seconds = watch.seconds();
+
+		std::uint64_t hits, misses;
+		WorldLocation::GetTimeZoneTileStatistics(&hits, &misses);
+		std::string label = "tile=" + std::to_string(tile);
+		report(label, rows * columns / seconds, "lookups/s");
+		report(label + " hit rate", (hits + misses) ? 100.0 * hits / (hits + misses) : 0.0, "%");
+	}
+
+	WorldLocation::SetTimeZoneTileResolution(resolution);
+}
+
+
+// the same grid as TimezoneTileCache answered from a TimezoneGrid built over it, and how long building one takes
+WTIME_BENCHMARK(TimezoneGridLookup)
+{
+	constexpr double degree = 0.017453292519943295;
+	constexpr int rows = 100, columns = 100;
+
+	Stopwatch watch;
+	TimezoneGrid grid;
+	grid.Build(50.0 * degree, -112.0 * degree, 50.5 * degree, -111.5 * degree, rows, columns, 0);
+	report("build", watch.seconds() * 1000.0, "ms");
+	report("border cells", (double)grid.BorderCount(), "cells");
+
+	watch.restart();
+	for (int pass = 0; pass < 10; pass++)
+		for (int r = 0; r < rows; r++)
+			for (int c = 0; c < columns; c++)
+				keep(grid.Lookup((50.0 + r * 0.005) * degree, (-112.0 + c * 0.005) * degree));
+	report("lookups", 10 * rows * columns / watch.seconds(), "lookups/s");
+}
+
+
+// 20000 ignition points where most are repeated, resolved one at a time and then through the batch interface
+WTIME_BENCHMARK(TimezoneBatch)
+{
+	constexpr double degree = 0.017453292519943295;
+	constexpr size_t count = 20000;
+
+	std::vector<double> lat(count), lon(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		size_t j = i % 2500;
+		lat[i] = (49.0 + (j * 37 % 1000) * 0.01) * degree;
+		lon[i] = (-120.0 + (j * 91 % 2000) * 0.01) * degree;
+	}
+	std::vector<const TimeZoneInfo*> out(count);
+	double resolution = WorldLocation::GetTimeZoneTileResolution();
+	WorldLocation::SetTimeZoneTileResolution(0.0);
+
+	Stopwatch watch;
+	for (size_t i = 0; i < count; i++)
+		out[i] = WorldLocation::TimeZoneFromLatLon(lat[i], lon[i], 0);
+	keep(out[count - 1]);
+	report("single", count / watch.seconds(), "points/s");
+
+	watch.restart();
+	WorldLocation::TimeZoneFromLatLon(lat.data(), lon.data(), count, 0, out.data());
+	keep(out[count - 1]);
+	report("batch", count / watch.seconds(), "points/s");
+
+	WorldLocation::SetTimeZoneTileResolution(resolution);
+}
+
+
+// local offsets for hourly times across 1950-2050, from the zone's transition table and straight from the tzdb
+WTIME_BENCHMARK(TimezoneHistoricalOffset)
+{
+	constexpr INTNM::uint64_t hour = 60LL * 60LL * 1000000LL;
+	constexpr int count = 100 * 365 * 24;
+
+	WorldLocation location;
+	location.SetTimeZoneOffset(WorldLocation::TimeZoneFromName("America/Edmonton", 1));
+	WTimeManager manager(location);
+	WTime start(1950, 1, 1, 0, 0, 0, &manager);
+	const INTNM::uint32_t flags = WTIME_FORMAT_AS_LOCAL | WTIME_FORMAT_WITHDST | WTIME_FORMAT_WITHHISTORY;
+
+	Stopwatch watch;
+	INTNM::int64_t total = 0;
+	for (int i = 0; i < count; i++)
+	{
+		WTime t(start.GetTotalMicroSeconds() + i * hour, &manager, false);
+		total += t.GetHour(flags);
+	}
+	keep(total);
+	report("transition table", count / watch.seconds(), "conversions/s");
+
+	const date::time_zone* tz = date::locate_zone("America/Edmonton");
+	date::sys_seconds sys_start = date::sys_days{ date::year{ 1950 } / date::jan / 1 };
+	watch.restart();
+	total = 0;
+	for (int i = 0; i < count; i++)
+	{
+		date::sys_info info = tz->get_info(sys_start + std::chrono::hours(i));
+		total += ((i + info.offset.count() / 3600) % 24 + 24) % 24;
+	}
+	keep(total);
+	report("date::time_zone::get_info", count / watch.seconds(), "conversions/s");
+}
+
+
+// the first lookup in a process, which pays for opening ZoneDetect and reading the tzdb, has to be measured in a fresh
+// process each time
+WTIME_BENCHMARK(_TimezoneColdStart)
+{
+	Stopwatch watch;
+	keep(WorldLocation::TimeZoneFromName("America/Edmonton", 0));
+	report("first lookup", watch.seconds() * 1000.0, "ms");
+}
+
+
+WTIME_BENCHMARK(_TimezoneColdStartLazy)
+{
+	TimezoneMapper::setLazyTzdb(true);
+	Stopwatch watch;
+	keep(WorldLocation::TimeZoneFromName("America/Edmonton", 0));
+	report("first lookup", watch.seconds() * 1000.0, "ms");
+	keep(WorldLocation::TimeZoneFromName("Europe/Paris", 0));
+	report("first lookup in a second region", watch.seconds() * 1000.0, "ms");
+}
+
+
+WTIME_BENCHMARK(_TimezoneColdStartPrewarm)
+{
+	WorldLocation::PrewarmTimeZones();
+	std::this_thread::sleep_for(std::chrono::milliseconds(500));		// the rest of the application starting up
+	Stopwatch watch;
+	keep(WorldLocation::TimeZoneFromName("America/Edmonton", 0));
+	report("first lookup after prewarming", watch.seconds() * 1000.0, "ms");
+	WorldLocation::FinishPrewarmTimeZones();
+}
+
+
+WTIME_BENCHMARK(TimezoneColdStart)
+{
+	printf("parsing the tzdb text\n");
+	runInProcess("_TimezoneColdStart", "WTIME_TZ_SNAPSHOT", "0");
+	printf("parsing the tzdb text a region at a time\n");
+	runInProcess("_TimezoneColdStartLazy", "WTIME_TZ_SNAPSHOT", "0");
+	printf("from the embedded snapshot\n");
+	runInProcess("_TimezoneColdStart");
+	printf("parsing the tzdb text on a prewarm thread\n");
+	runInProcess("_TimezoneColdStartPrewarm", "WTIME_TZ_SNAPSHOT", "0");
+}
+
+
+WTIME_BENCHMARK(_TimezoneMemory)
+{
+	constexpr double degree = 0.017453292519943295;
+	reportMemory("before");
+	for (double lat = 42.0; lat < 70.0; lat += 0.5)
+		for (double lon = -140.0; lon < -52.0; lon += 0.5)
+			keep(WorldLocation::TimeZoneFromLatLon(lat * degree, lon * degree, 0));
+	reportMemory("after lookups");
+}
+
+
+WTIME_BENCHMARK(TimezoneMemory)
+{
+	// an empty path is the same as not setting it
+	const char* path = getenv("WTIME_ZONEDETECT_DB");
+	std::string database = path ? path : "";
+	printf("embedded ZoneDetect database\n");
+	runInProcess("_TimezoneMemory", "WTIME_ZONEDETECT_DB", "");
+	if (database.empty())
+		printf("set WTIME_ZONEDETECT_DB to a ZoneDetect database file to compare it with the embedded one\n");
+	else {
+		printf("mapped ZoneDetect database %s\n", database.c_str());
+		runInProcess("_TimezoneMemory", "WTIME_ZONEDETECT_DB", database.c_str());
+	}
+}
@@ -0,0 +1,246 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <sstream>
+
+#include "WTime.h"
+
+using namespace HSS_Time;
+
+
+namespace
+{
+TEST(TimezoneMapperTest, PrewarmDoesNotRaceLookups)
+{
+    WorldLocation::PrewarmTimeZones();
+    std::vector<std::thread> threads;
+    std::atomic<int> failures(0);
+    for (int i = 0; i < 4; i++)
+        threads.emplace_back([&failures]() {
+            const TimeZoneInfo* tzi = WorldLocation::TimeZoneFromName("America/Regina", 0);
+            if ((!tzi) || (tzi->m_timezone.GetTotalSeconds() != -6 * 60 * 60))
+                failures++;
+        });
+    WorldLocation::PrewarmTimeZones();
+    for (auto& thread : threads)
+        thread.join();
+    EXPECT_EQ(0, failures.load());
+
+    // joins the prewarm thread, and is safe to repeat
+    WorldLocation::FinishPrewarmTimeZones();
+    WorldLocation::FinishPrewarmTimeZones();
+}
+
+TEST(TimezoneMapperTest, NameRoundTrip)
+{
+    const TimeZoneInfo* first = WorldLocation::TimeZoneFromName("America/Edmonton", 0);
+    ASSERT_NE(nullptr, first);
+    EXPECT_STREQ("America/Edmonton", first->m_name);
+
+    const TimeZoneInfo* second = WorldLocation::TimeZoneFromName("america/edmonton", 0);
+    EXPECT_EQ(first, second);
+
+    const TimeZoneInfo* dst = WorldLocation::TimeZoneFromName("America/Edmonton", 1);
+    ASSERT_NE(nullptr, dst);
+    EXPECT_NE(first, dst);
+    EXPECT_NE(0, dst->m_dst.GetTotalSeconds());
+}
+
+TEST(TimezoneMapperTest, IdRoundTrip)
+{
+    const TimeZoneInfo* tzi = WorldLocation::TimeZoneFromName("Europe/Paris", 0);
+    ASSERT_NE(nullptr, tzi);
+    EXPECT_EQ(tzi, WorldLocation::TimeZoneFromId(tzi->m_id));
+}
+
+TEST(TimezoneMapperTest, ConcurrentLookups)
+{
+    static const char* names[] = {
+        "America/Halifax", "America/Regina", "Asia/Tokyo", "Australia/Perth",
+        "Africa/Cairo", "Europe/Berlin", "Pacific/Auckland", "America/Sao_Paulo"
+    };
+    constexpr size_t count = sizeof(names) / sizeof(names[0]);
+
+    std::atomic<int> mismatches(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++)
+    {
+        threads.emplace_back([&mismatches]()
+        {
+            const TimeZoneInfo* seen[count] = {};
+            for (int pass = 0; pass < 100; pass++)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    const TimeZoneInfo* tzi = WorldLocation::TimeZoneFromName(names[i], 0);
+                    if (!tzi || (seen[i] && seen[i] != tzi) || (WorldLocation::TimeZoneFromId(tzi->m_id) != tzi))
+                        mismatches++;
+                    seen[i] = tzi;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    EXPECT_EQ(0, mismatches.load());
+}
+
+TEST(TimezoneMapperTest, TileCacheMatchesLookup)
+{
+    constexpr double degree = 0.017453292519943295;
+    double resolution = WorldLocation::GetTimeZoneTileResolution();
+
+    // a walk across the prairies that crosses the Alberta/Saskatchewan border
+    std::vector<const TimeZoneInfo*> expected;
+    WorldLocation::SetTimeZoneTileResolution(0.0);
+    for (int i = 0; i < 200; i++)
+        expected.push_back(WorldLocation::TimeZoneFromLatLon(52.0 * degree, (-109.0 - i * 0.01) * degree, 0));
+
+    WorldLocation::SetTimeZoneTileResolution(0.01);
+    WorldLocation::ClearTimeZoneTileCache();
+    for (int pass = 0; pass < 2; pass++)
+        for (int i = 0; i < 200; i++)
+            EXPECT_EQ(expected[i], WorldLocation::TimeZoneFromLatLon(52.0 * degree, (-109.0 - i * 0.01) * degree, 0));
+
+    std::uint64_t hits, misses;
+    WorldLocation::GetTimeZoneTileStatistics(&hits, &misses);
+    EXPECT_EQ(400U, hits + misses);
+    EXPECT_GT(hits, 150U);
+
+    WorldLocation::SetTimeZoneTileResolution(resolution);
+}
+
+TEST(TimezoneMapperTest, BatchMatchesSingle)
+{
+    constexpr double degree = 0.017453292519943295;
+    std::vector<double> lat, lon;
+    for (int i = 0; i < 500; i++)
+    {
+        // stations scattered across Canada with every fifth one repeated
+        int j = (i % 5 == 4) ? i - 1 : i;
+        lat.push_back((45.0 + (j * 37 % 150) * 0.1) * degree);
+        lon.push_back((-125.0 + (j * 91 % 600) * 0.1) * degree);
+    }
+
+    std::vector<const TimeZoneInfo*> batch(lat.size());
+    std::unique_ptr<bool[]> valid(new bool[lat.size()]);
+    WorldLocation::TimeZoneFromLatLon(lat.data(), lon.data(), lat.size(), 1, batch.data(), valid.get());
+
+    for (size_t i = 0; i < lat.size(); i++)
+    {
+        bool single_valid = false;
+        EXPECT_EQ(WorldLocation::TimeZoneFromLatLon(lat[i], lon[i], 1, &single_valid), batch[i]);
+        EXPECT_EQ(single_valid, valid[i]);
+    }
+}
+
+TEST(TimezoneGridTest, MatchesLookup)
+{
+    constexpr double degree = 0.017453292519943295;
+    double resolution = WorldLocation::GetTimeZoneTileResolution();
+
+    // straddles the Alberta/Saskatchewan border south of Lloydminster, and the US border along its southern edge
+    TimezoneGrid grid;
+    ASSERT_TRUE(grid.Build(49.0 * degree, -112.0 * degree, 52.0 * degree, -107.0 * degree, 30, 50, 0));
+    EXPECT_GT(grid.BorderCount(), 0U);
+    EXPECT_LT(grid.BorderCount(), 30U * 50U / 4);
+
+    WorldLocation::SetTimeZoneTileResolution(0.0);
+    for (int i = 0; i < 1000; i++)
+    {
+        // includes points outside of the grid
+        double lat = (48.5 + (i * 37 % 400) * 0.01) * degree;
+        double lon = (-112.5 + (i * 91 % 600) * 0.01) * degree;
+        bool valid, expected_valid;
+        const TimeZoneInfo* expected = WorldLocation::TimeZoneFromLatLon(lat, lon, 0, &expected_valid);
+        EXPECT_EQ(expected, grid.Lookup(lat, lon, &valid));
+        EXPECT_EQ(expected_valid, valid);
+    }
+    WorldLocation::SetTimeZoneTileResolution(resolution);
+}
+
+TEST(TimezoneGridTest, SaveLoadRoundTrip)
+{
+    constexpr double degree = 0.017453292519943295;
+    TimezoneGrid grid;
+    ASSERT_TRUE(grid.Build(49.0 * degree, -120.0 * degree, 60.0 * degree, -100.0 * degree, 44, 80, 1));
+
+    std::stringstream stream;
+    ASSERT_TRUE(grid.Save(stream));
+    TimezoneGrid loaded;
+    ASSERT_TRUE(loaded.Load(stream));
+    ASSERT_EQ(grid.Rows(), loaded.Rows());
+    ASSERT_EQ(grid.Columns(), loaded.Columns());
+    EXPECT_EQ(grid.BorderCount(), loaded.BorderCount());
+    for (std::uint32_t r = 0; r < grid.Rows(); r++)
+        for (std::uint32_t c = 0; c < grid.Columns(); c++)
+        {
+            double lat = (49.0 + (r + 0.5) * 0.25) * degree;
+            double lon = (-120.0 + (c + 0.5) * 0.25) * degree;
+            EXPECT_EQ(grid.Lookup(lat, lon), loaded.Lookup(lat, lon));
+        }
+
+    std::string damaged = stream.str();
+    damaged.resize(damaged.size() / 2);
+    std::stringstream truncated(damaged);
+    EXPECT_FALSE(loaded.Load(truncated));
+    EXPECT_TRUE(loaded.IsEmpty());
+
+    // a zone the tzdb doesn't know
+    std::string renamed = stream.str();
+    std::size_t name = renamed.find("America/");
+    ASSERT_NE(std::string::npos, name);
+    renamed.replace(name, 8, "Nowhere/");
+    std::stringstream unknown(renamed), reload(stream.str());
+    ASSERT_TRUE(loaded.Load(reload));
+    EXPECT_FALSE(loaded.Load(unknown));
+    EXPECT_TRUE(loaded.IsEmpty());
+}
+
+TEST(TimezoneTransitionsTest, HistoricalOffsets)
+{
+    const TimeZoneInfo* tzi = WorldLocation::TimeZoneFromName("America/Edmonton", 1);
+    ASSERT_NE(nullptr, tzi);
+    ASSERT_NE(nullptr, tzi->m_transitions);
+
+    WorldLocation location;
+    location.SetTimeZoneOffset(tzi);
+    WTimeManager manager(location);
+    constexpr INTNM::uint32_t flags = WTIME_FORMAT_AS_LOCAL | WTIME_FORMAT_WITHDST | WTIME_FORMAT_WITHHISTORY;
+
+    // before the 2007 rule change daylight savings didn't start until April
+    WTime before(2005, 3, 20, 18, 0, 0, &manager);
+    EXPECT_EQ(11, before.GetHour(flags));
+
+    WTime summer(2022, 7, 1, 12, 0, 0, &manager);
+    EXPECT_EQ(6, summer.GetHour(flags));
+    EXPECT_EQ(5, summer.GetHour(WTIME_FORMAT_AS_LOCAL | WTIME_FORMAT_WITHHISTORY));
+
+    // local mean time, -7:33:52, until 1906
+    WTime lmt(1900, 1, 1, 12, 0, 0, &manager);
+    EXPECT_EQ(4, lmt.GetHour(flags));
+    EXPECT_EQ(26, lmt.GetMinute(flags));
+    EXPECT_EQ(8, lmt.GetSecond(flags));
+
+    // past the end of the table the last 400 years repeat
+    WTime future(3000, 7, 1, 12, 0, 0, &manager);
+    EXPECT_EQ(6, future.GetHour(flags));
+    WTime future_winter(3000, 1, 15, 12, 0, 0, &manager);
+    EXPECT_EQ(5, future_winter.GetHour(flags));
+}
+
+TEST(TimezoneTransitionsTest, FixedZonesFallBack)
+{
+    WorldLocation location;
+    location.SetTimeZoneOffset(WorldLocation::TimeZoneFromName("MDT", 1));
+    WTimeManager manager(location);
+
+    WTime t(2005, 3, 20, 18, 0, 0, &manager);
+    EXPECT_EQ(t.GetHour(WTIME_FORMAT_AS_LOCAL | WTIME_FORMAT_WITHDST),
+        t.GetHour(WTIME_FORMAT_AS_LOCAL | WTIME_FORMAT_WITHDST | WTIME_FORMAT_WITHHISTORY));
+}
+}